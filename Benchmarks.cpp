@@ -0,0 +1,335 @@
+#include "PhysicsSystem.hpp"
+#include "SparseSet.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the SparseSet and PhysicsSystem hot paths:
+//   physics-bench [output json]
+// A table goes to stdout and the same numbers go to a JSON file (default
+// bench_results.json) so runs from different commits can be diffed.
+
+namespace
+{
+
+struct BenchResult
+{
+    std::string name;
+    size_t      bodies;     // dynamic objects (or set size for SparseSet benchmarks)
+    size_t      statics;
+    size_t      ops;        // operations per repetition
+    double      ns_per_op;  // median over repetitions
+    double      bodies_per_second; // objects processed per second
+};
+
+volatile float sink = 0.0f; // keeps results observable so loops aren't optimised out
+
+constexpr int REPETITIONS = 7;
+
+// Runs setup then the timed body REPETITIONS times and returns the median ns/op.
+template<typename Setup, typename Body>
+double measure(size_t ops, Setup setup, Body body)
+{
+    std::vector<double> samples;
+    for (int r = 0; r < REPETITIONS; r++)
+    {
+        setup();
+        auto start = std::chrono::high_resolution_clock::now();
+        body();
+        auto end = std::chrono::high_resolution_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops));
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+phys::DynamicObject make_object(size_t i)
+{
+    return { glm::vec3(float(i), 0.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f };
+}
+
+void bench_sparse_set(size_t size, std::vector<BenchResult>& results)
+{
+    std::mt19937 rng(42);
+
+    SparseSet<phys::DynamicObject> set(size);
+    std::vector<uint32_t>          handles;
+
+    auto fill = [&]()
+    {
+        set = SparseSet<phys::DynamicObject>(size);
+        handles.clear();
+        for (size_t i = 0; i < size; i++)
+        {
+            handles.push_back(set.add(make_object(i)));
+        }
+    };
+
+    double add_ns = measure(size, [&]() { set = SparseSet<phys::DynamicObject>(size); handles.clear(); }, [&]()
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            handles.push_back(set.add(make_object(i)));
+        }
+    });
+    results.push_back({ "sparse_set_add", size, 0, size, add_ns, 1e9 / add_ns });
+
+    std::vector<uint32_t> lookups(size);
+    double get_ns = measure(size, [&]()
+    {
+        fill();
+        for (size_t i = 0; i < size; i++)
+        {
+            lookups[i] = handles[rng() % handles.size()];
+        }
+    }, [&]()
+    {
+        float total = 0.0f;
+        for (uint32_t handle : lookups)
+        {
+            total += set.get(handle).position.x;
+        }
+        sink = total;
+    });
+    results.push_back({ "sparse_set_get", size, 0, size, get_ns, 1e9 / get_ns });
+
+    double has_ns = measure(size, [&]() {}, [&]()
+    {
+        size_t found = 0;
+        for (uint32_t handle : lookups)
+        {
+            found += set.has(handle) ? 1 : 0;
+        }
+        sink = float(found);
+    });
+    results.push_back({ "sparse_set_has", size, 0, size, has_ns, 1e9 / has_ns });
+
+    double dense_ns = measure(size, [&]() {}, [&]()
+    {
+        float total = 0.0f;
+        for (phys::DynamicObject& object : set.get_dense())
+        {
+            total += object.position.x;
+        }
+        sink = total;
+    });
+    results.push_back({ "sparse_set_dense_iterate", size, 0, size, dense_ns, 1e9 / dense_ns });
+
+    double remove_ns = measure(size, [&]()
+    {
+        fill();
+        std::shuffle(handles.begin(), handles.end(), rng);
+    }, [&]()
+    {
+        for (uint32_t handle : handles)
+        {
+            set.remove(handle);
+        }
+    });
+    results.push_back({ "sparse_set_remove", size, 0, size, remove_ns, 1e9 / remove_ns });
+
+    // Remove a random live object and add a new one, over and over. Exercises
+    // swap-and-pop and handle reuse from the free list together.
+    double churn_ns = measure(size, [&]() { fill(); }, [&]()
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            size_t slot = rng() % handles.size();
+            set.remove(handles[slot]);
+            handles[slot] = set.add(make_object(i));
+        }
+    });
+    results.push_back({ "sparse_set_churn", size, 0, size, churn_ns, 1e9 / churn_ns });
+}
+
+void bench_box_contacts(size_t candidates, std::vector<BenchResult>& results)
+{
+    const size_t queries = 1000000 / candidates; // about a million boxes per repetition, whatever the batch size
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+    std::vector<glm::vec3> positions(candidates);
+    for (glm::vec3& position : positions)
+    {
+        position = glm::vec3(offset(rng), offset(rng), offset(rng));
+    }
+    std::vector<glm::vec3> half_extents(candidates, glm::vec3(0.5f));
+    std::vector<float>   depths(candidates);
+    std::vector<int32_t> axes(candidates);
+    std::vector<float>   directions(candidates);
+
+    auto run = [&](auto kernel)
+    {
+        return measure(queries * candidates, []() {}, [&]()
+        {
+            for (size_t q = 0; q < queries; q++)
+            {
+                kernel(glm::vec3(0.0f), glm::vec3(0.5f), positions.data(), half_extents.data(), candidates,
+                       depths.data(), axes.data(), directions.data());
+                sink = sink + depths[q % candidates];
+            }
+        });
+    };
+
+    double scalar_ns = run(phys::find_box_contacts_scalar);
+    results.push_back({ "box_contacts_scalar", candidates, 0, queries * candidates, scalar_ns, 1e9 / scalar_ns });
+
+    double ns = run(phys::find_box_contacts);
+    results.push_back({ "box_contacts", candidates, 0, queries * candidates, ns, 1e9 / ns });
+}
+
+void bench_step(size_t bodies, size_t statics, phys::StaticBroadphase broadphase, std::vector<BenchResult>& results)
+{
+    const size_t ticks = 20;
+    const float  tick_duration = 1.0f / 60.0f;
+
+    std::unique_ptr<phys::PhysicsSystem> physics_system;
+
+    double ns = measure(ticks, [&]()
+    {
+        physics_system = std::make_unique<phys::PhysicsSystem>();
+        physics_system->set_static_broadphase(broadphase);
+
+        // A square floor of statics with the bodies dropped onto it.
+        size_t side = static_cast<size_t>(std::ceil(std::sqrt(double(statics))));
+        for (size_t i = 0; i < statics; i++)
+        {
+            physics_system->add_static(glm::vec3(float(i % side), -3.0f, float(i / side)));
+        }
+        physics_system->rebuild_static_broadphase();
+
+        // One body per floor block, stacking up once every block has one.
+        for (size_t i = 0; i < bodies; i++)
+        {
+            size_t    column = i % statics;
+            size_t    layer  = i / statics;
+            glm::vec3 pos    = glm::vec3(float(column % side), -1.5f + 1.5f * float(layer), float(column / side));
+            physics_system->add_dynamic(pos, glm::vec3(0.0f), glm::vec3(0.0f), 1.0f);
+        }
+    }, [&]()
+    {
+        for (size_t tick = 0; tick < ticks; tick++)
+        {
+            physics_system->step(tick_duration);
+        }
+    });
+
+    const char* name = (broadphase == phys::StaticBroadphase::voxel_grid) ? "physics_step_voxel" : "physics_step";
+    results.push_back({ name, bodies, statics, ticks, ns, double(bodies) * 1e9 / ns });
+}
+
+void bench_world_snapshot(size_t bodies, std::vector<BenchResult>& results)
+{
+    // Spread out and awake, so every body has moved since the snapshot and
+    // restore copies everything back.
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> across(0.0f, 20000.0f);
+    std::uniform_real_distribution<float> up(0.0f, 200.0f);
+
+    std::vector<phys::DynamicObject> objects(bodies);
+    for (phys::DynamicObject& object : objects)
+    {
+        object = { glm::vec3(across(rng), up(rng), across(rng)), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f };
+    }
+
+    phys::PhysicsSystem          physics_system;
+    std::vector<phys::DynamicID> ids;
+    physics_system.set_sleeping(false);
+    physics_system.add_dynamics(objects, ids);
+    physics_system.step(1.0f / 60.0f);
+
+    phys::WorldSnapshot snapshot;
+    physics_system.snapshot(snapshot); // sizes the buffer, later saves reuse it
+
+    double save_ns = measure(1, []() {}, [&]()
+    {
+        physics_system.snapshot(snapshot);
+    });
+    results.push_back({ "world_snapshot", bodies, 0, 1, save_ns, double(bodies) * 1e9 / save_ns });
+
+    double restore_ns = measure(1, [&]()
+    {
+        physics_system.step(1.0f / 60.0f);
+    }, [&]()
+    {
+        physics_system.restore(snapshot);
+    });
+    results.push_back({ "world_restore", bodies, 0, 1, restore_ns, double(bodies) * 1e9 / restore_ns });
+}
+
+void write_json(const std::string& path, const std::vector<BenchResult>& results)
+{
+    std::ofstream file(path);
+    if (not file)
+    {
+        throw std::runtime_error(std::format("Could not open {} for writing", path));
+    }
+
+    file << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& r = results[i];
+        file << std::format("    {{\"name\": \"{}\", \"bodies\": {}, \"statics\": {}, \"ops\": {}, \"ns_per_op\": {:.3f}, \"bodies_per_second\": {:.1f}}}",
+                            r.name, r.bodies, r.statics, r.ops, r.ns_per_op, r.bodies_per_second);
+        file << ((i + 1 < results.size()) ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        std::string json_path = (argc > 1) ? argv[1] : "bench_results.json";
+
+        std::vector<BenchResult> results;
+
+        for (size_t size : { 100, 1000, 10000, 100000 })
+        {
+            bench_sparse_set(size, results);
+        }
+
+        for (size_t candidates : { 8, 64, 1024 })
+        {
+            bench_box_contacts(candidates, results);
+        }
+
+        for (size_t bodies : { 10000, 100000, 1000000 })
+        {
+            bench_world_snapshot(bodies, results);
+        }
+
+        for (size_t statics : { 100, 1000, 10000 })
+        {
+            for (size_t bodies : { 10, 100, 1000, 10000 })
+            {
+                bench_step(bodies, statics, phys::StaticBroadphase::bvh, results);
+                bench_step(bodies, statics, phys::StaticBroadphase::voxel_grid, results);
+            }
+        }
+
+        std::cout << std::format("{:<26}{:>8}{:>9}{:>14}{:>16}", "benchmark", "bodies", "statics", "ns/op", "bodies/s") << std::endl;
+        for (const BenchResult& r : results)
+        {
+            std::cout << std::format("{:<26}{:>8}{:>9}{:>14.2f}{:>16.0f}", r.name, r.bodies, r.statics, r.ns_per_op, r.bodies_per_second) << std::endl;
+        }
+
+        write_json(json_path, results);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
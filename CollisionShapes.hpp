@@ -0,0 +1,300 @@
+#pragma once
+#include "ContactKernel.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+// Every shape is described by its half extents, which are also its bounding
+// box, so the broadphases never need to know the shape. Bodies don't rotate:
+//   aabb    - the box itself
+//   sphere  - radius half_extents.x, every half extent equal
+//   capsule - upright, radius half_extents.x (= half_extents.z), its tips at
+//             position.y +- half_extents.y
+enum class ShapeType : uint8_t
+{
+    aabb    = 0,
+    sphere  = 1,
+    capsule = 2
+};
+
+constexpr size_t SHAPE_TYPE_COUNT = 3;
+
+/// <summary>
+/// Whether the half extents describe a valid shape of the given type, see ShapeType.
+/// </summary>
+inline bool is_valid_shape(ShapeType type, const glm::vec3& half_extents)
+{
+    if (not (half_extents.x > 0.0f and half_extents.y > 0.0f and half_extents.z > 0.0f))
+    {
+        return false;
+    }
+    switch (type)
+    {
+        case ShapeType::aabb:
+            return true;
+        case ShapeType::sphere:
+            return half_extents.x == half_extents.y and half_extents.x == half_extents.z;
+        case ShapeType::capsule:
+            return half_extents.x == half_extents.z and half_extents.y >= half_extents.x;
+    }
+    return false;
+}
+
+/// <summary>
+/// How shape b touches shape a.
+/// </summary>
+struct ShapeContact
+{
+    glm::vec3 normal; // unit, pointing from a to b
+    float     depth;  // penetration along normal, <= 0 when the shapes don't touch
+    int32_t   axis;   // axis normal is closest to, 0 = x, 1 = y, 2 = z
+};
+
+namespace shape_detail
+{
+
+inline ShapeContact from_box_contact(const BoxContact& box)
+{
+    glm::vec3 normal = glm::vec3(0.0f);
+    normal[box.axis] = box.direction;
+    return { normal, box.depth, box.axis };
+}
+
+inline int32_t major_axis(const glm::vec3& normal)
+{
+    glm::vec3 size = glm::abs(normal);
+    int32_t   axis = (size.y > size.x) ? 1 : 0;
+    return (size.z > size[axis]) ? 2 : axis;
+}
+
+// Two spheres, or the closest points of two round shapes. Concentric ones
+// have no direction to separate along, so they fall back to the contact of
+// the shapes' bounding boxes.
+inline ShapeContact round_contact(const glm::vec3& center_a, float radius_a, const glm::vec3& center_b, float radius_b,
+                                  const BoxContact& fallback)
+{
+    glm::vec3 delta    = center_b - center_a;
+    float     distance = glm::length(delta);
+    if (distance > 0.0f)
+    {
+        glm::vec3 normal = delta / distance;
+        return { normal, radius_a + radius_b - distance, major_axis(normal) };
+    }
+    return from_box_contact(fallback);
+}
+
+// A sphere and a box. A centre inside the box has no closest point to push
+// out from, so that also falls back to the bounding boxes.
+inline ShapeContact sphere_box_contact(const glm::vec3& center, float radius, const glm::vec3& box_position,
+                                       const glm::vec3& box_half_extents, const BoxContact& fallback)
+{
+    glm::vec3 closest  = glm::clamp(center, box_position - box_half_extents, box_position + box_half_extents);
+    glm::vec3 delta    = closest - center;
+    float     distance = glm::length(delta);
+    if (distance > 0.0f)
+    {
+        glm::vec3 normal = delta / distance;
+        return { normal, radius - distance, major_axis(normal) };
+    }
+    return from_box_contact(fallback);
+}
+
+// Lowest and highest point of a capsule's core segment.
+inline float segment_bottom(const glm::vec3& position, const glm::vec3& half_extents)
+{
+    return position.y - (half_extents.y - half_extents.x);
+}
+
+inline float segment_top(const glm::vec3& position, const glm::vec3& half_extents)
+{
+    return position.y + (half_extents.y - half_extents.x);
+}
+
+}
+
+/// <summary>
+/// Contact test for one pair of shape types, resolved at compile time.
+/// Only one order of each pair is written out, the other one swaps the
+/// arguments and flips the normal.
+/// </summary>
+template<ShapeType A, ShapeType B>
+struct ShapePair
+{
+    static ShapeContact collide(const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                const glm::vec3& position_b, const glm::vec3& half_extents_b)
+    {
+        ShapeContact contact = ShapePair<B, A>::collide(position_b, half_extents_b, position_a, half_extents_a);
+        contact.normal = -contact.normal;
+        return contact;
+    }
+};
+
+template<>
+struct ShapePair<ShapeType::aabb, ShapeType::aabb>
+{
+    static ShapeContact collide(const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                const glm::vec3& position_b, const glm::vec3& half_extents_b)
+    {
+        return shape_detail::from_box_contact(find_box_contact(position_a, position_b, half_extents_a + half_extents_b));
+    }
+};
+
+template<>
+struct ShapePair<ShapeType::sphere, ShapeType::sphere>
+{
+    static ShapeContact collide(const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                const glm::vec3& position_b, const glm::vec3& half_extents_b)
+    {
+        return shape_detail::round_contact(position_a, half_extents_a.x, position_b, half_extents_b.x,
+                                           find_box_contact(position_a, position_b, half_extents_a + half_extents_b));
+    }
+};
+
+template<>
+struct ShapePair<ShapeType::sphere, ShapeType::aabb>
+{
+    static ShapeContact collide(const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                const glm::vec3& position_b, const glm::vec3& half_extents_b)
+    {
+        return shape_detail::sphere_box_contact(position_a, half_extents_a.x, position_b, half_extents_b,
+                                                find_box_contact(position_a, position_b, half_extents_a + half_extents_b));
+    }
+};
+
+template<>
+struct ShapePair<ShapeType::capsule, ShapeType::capsule>
+{
+    static ShapeContact collide(const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                const glm::vec3& position_b, const glm::vec3& half_extents_b)
+    {
+        // Both segments are upright, so the closest points share the middle of
+        // the height range the segments have in common. When they have none,
+        // that middle lies in the gap and clamping takes it to the facing ends.
+        float bottom_a = shape_detail::segment_bottom(position_a, half_extents_a);
+        float top_a    = shape_detail::segment_top(position_a, half_extents_a);
+        float bottom_b = shape_detail::segment_bottom(position_b, half_extents_b);
+        float top_b    = shape_detail::segment_top(position_b, half_extents_b);
+        float middle   = (glm::max(bottom_a, bottom_b) + glm::min(top_a, top_b)) * 0.5f;
+
+        glm::vec3 closest_a = glm::vec3(position_a.x, glm::clamp(middle, bottom_a, top_a), position_a.z);
+        glm::vec3 closest_b = glm::vec3(position_b.x, glm::clamp(middle, bottom_b, top_b), position_b.z);
+        return shape_detail::round_contact(closest_a, half_extents_a.x, closest_b, half_extents_b.x,
+                                           find_box_contact(position_a, position_b, half_extents_a + half_extents_b));
+    }
+};
+
+template<>
+struct ShapePair<ShapeType::capsule, ShapeType::sphere>
+{
+    static ShapeContact collide(const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                const glm::vec3& position_b, const glm::vec3& half_extents_b)
+    {
+        float     height  = glm::clamp(position_b.y, shape_detail::segment_bottom(position_a, half_extents_a),
+                                       shape_detail::segment_top(position_a, half_extents_a));
+        glm::vec3 closest = glm::vec3(position_a.x, height, position_a.z);
+        return shape_detail::round_contact(closest, half_extents_a.x, position_b, half_extents_b.x,
+                                           find_box_contact(position_a, position_b, half_extents_a + half_extents_b));
+    }
+};
+
+template<>
+struct ShapePair<ShapeType::capsule, ShapeType::aabb>
+{
+    static ShapeContact collide(const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                const glm::vec3& position_b, const glm::vec3& half_extents_b)
+    {
+        // The point of the segment nearest the box is at the height of the
+        // box's centre, clamped to the segment.
+        float     height  = glm::clamp(position_b.y, shape_detail::segment_bottom(position_a, half_extents_a),
+                                       shape_detail::segment_top(position_a, half_extents_a));
+        glm::vec3 closest = glm::vec3(position_a.x, height, position_a.z);
+        return shape_detail::sphere_box_contact(closest, half_extents_a.x, position_b, half_extents_b,
+                                                find_box_contact(position_a, position_b, half_extents_a + half_extents_b));
+    }
+};
+
+/// <summary>
+/// One shape of type A against count shapes of type B.
+/// </summary>
+template<ShapeType A, ShapeType B>
+void collide_shape_batch(const glm::vec3& position, const glm::vec3& half_extents,
+                         const glm::vec3* positions, const glm::vec3* half_extents_b, size_t count, ShapeContact* out)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = ShapePair<A, B>::collide(position, half_extents, positions[i], half_extents_b[i]);
+    }
+}
+
+/// <summary>
+/// count pairs of shapes, the first of each of type A and the second of type B.
+/// </summary>
+/// <param name="pairs">: indices into positions and half_extents</param>
+template<ShapeType A, ShapeType B>
+void collide_shape_pairs(const glm::vec3* positions, const glm::vec3* half_extents,
+                         const std::pair<uint32_t, uint32_t>* pairs, size_t count, ShapeContact* out)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        auto [a, b] = pairs[i];
+        out[i] = ShapePair<A, B>::collide(positions[a], half_extents[a], positions[b], half_extents[b]);
+    }
+}
+
+using ShapeBatchFunction = void (*)(const glm::vec3&, const glm::vec3&, const glm::vec3*, const glm::vec3*, size_t, ShapeContact*);
+using ShapePairsFunction = void (*)(const glm::vec3*, const glm::vec3*, const std::pair<uint32_t, uint32_t>*, size_t, ShapeContact*);
+
+/// <summary>
+/// Index of a pair of shape types in the tables below.
+/// </summary>
+constexpr size_t shape_pair_index(ShapeType a, ShapeType b)
+{
+    return size_t(a) * SHAPE_TYPE_COUNT + size_t(b);
+}
+
+namespace shape_detail
+{
+
+template<size_t... I>
+constexpr std::array<ShapeBatchFunction, sizeof...(I)> make_batch_table(std::index_sequence<I...>)
+{
+    return { &collide_shape_batch<ShapeType(I / SHAPE_TYPE_COUNT), ShapeType(I % SHAPE_TYPE_COUNT)>... };
+}
+
+template<size_t... I>
+constexpr std::array<ShapePairsFunction, sizeof...(I)> make_pairs_table(std::index_sequence<I...>)
+{
+    return { &collide_shape_pairs<ShapeType(I / SHAPE_TYPE_COUNT), ShapeType(I % SHAPE_TYPE_COUNT)>... };
+}
+
+}
+
+// Every pair of shape types gets its own instantiation of the loops above, so
+// picking one is a single lookup per batch and the loop itself never looks
+// at a shape type. A new shape only needs its ShapePair specializations.
+inline constexpr std::array<ShapeBatchFunction, SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT> SHAPE_BATCH_KERNELS =
+    shape_detail::make_batch_table(std::make_index_sequence<SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT>());
+
+inline constexpr std::array<ShapePairsFunction, SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT> SHAPE_PAIR_KERNELS =
+    shape_detail::make_pairs_table(std::make_index_sequence<SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT>());
+
+/// <summary>
+/// Single pair test for when the shape types are only known at runtime.
+/// Anything testing many pairs should group them by type and use the tables.
+/// </summary>
+inline ShapeContact collide_shapes(ShapeType type_a, const glm::vec3& position_a, const glm::vec3& half_extents_a,
+                                   ShapeType type_b, const glm::vec3& position_b, const glm::vec3& half_extents_b)
+{
+    ShapeContact contact;
+    SHAPE_BATCH_KERNELS[shape_pair_index(type_a, type_b)](position_a, half_extents_a, &position_b, &half_extents_b, 1, &contact);
+    return contact;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "ContactKernel.hpp"
+
+#ifdef PHYS_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+using FindContactsFunction = void (*)(const glm::vec3&, const glm::vec3&, const glm::vec3*, const glm::vec3*, size_t, float*, int32_t*, float*);
+
+FindContactsFunction select_kernel()
+{
+#ifdef PHYS_X86
+    if (phys::cpu_supports_avx2())
+    {
+        return phys::find_box_contacts_avx2;
+    }
+#endif
+    return phys::find_box_contacts_scalar;
+}
+
+}
+
+void phys::find_box_contacts(const glm::vec3& center, const glm::vec3& half_extents, const glm::vec3* candidates,
+                             const glm::vec3* candidate_half_extents, size_t count, float* depths, int32_t* axes, float* directions)
+{
+    static const FindContactsFunction kernel = select_kernel();
+    kernel(center, half_extents, candidates, candidate_half_extents, count, depths, axes, directions);
+}
+
+void phys::find_box_contacts_scalar(const glm::vec3& center, const glm::vec3& half_extents, const glm::vec3* candidates,
+                                    const glm::vec3* candidate_half_extents, size_t count, float* depths, int32_t* axes, float* directions)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        BoxContact contact = find_box_contact(center, candidates[i], half_extents + candidate_half_extents[i]);
+        depths[i]     = contact.depth;
+        axes[i]       = contact.axis;
+        directions[i] = contact.direction;
+    }
+}
+
+#ifdef PHYS_X86
+
+PHYS_TARGET_AVX2
+void phys::find_box_contacts_avx2(const glm::vec3& center, const glm::vec3& half_extents, const glm::vec3* candidates,
+                                  const glm::vec3* candidate_half_extents, size_t count, float* depths, int32_t* axes, float* directions)
+{
+    // Eight packed vec3s load as three registers of interleaved x, y and z.
+    // Blending the three together puts every x in some lane (likewise y and
+    // z), and a permute then puts candidate k in lane k.
+    const __m256i x_order = _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5);
+    const __m256i y_order = _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6);
+    const __m256i z_order = _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7);
+
+    const __m256 center_x = _mm256_set1_ps(center.x);
+    const __m256 center_y = _mm256_set1_ps(center.y);
+    const __m256 center_z = _mm256_set1_ps(center.z);
+    const __m256 extent_x = _mm256_set1_ps(half_extents.x);
+    const __m256 extent_y = _mm256_set1_ps(half_extents.y);
+    const __m256 extent_z = _mm256_set1_ps(half_extents.z);
+    const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+    const __m256 zero     = _mm256_setzero_ps();
+    const __m256 plus     = _mm256_set1_ps(1.0f);
+    const __m256 minus    = _mm256_set1_ps(-1.0f);
+    const __m256 axis_y   = _mm256_castsi256_ps(_mm256_set1_epi32(1));
+    const __m256 axis_z   = _mm256_castsi256_ps(_mm256_set1_epi32(2));
+
+    const float* c = &candidates[0].x;
+    const float* e = &candidate_half_extents[0].x;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 r0 = _mm256_loadu_ps(c + 3 * i);
+        __m256 r1 = _mm256_loadu_ps(c + 3 * i + 8);
+        __m256 r2 = _mm256_loadu_ps(c + 3 * i + 16);
+
+        __m256 x = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(r0, r1, 0x92), r2, 0x24), x_order);
+        __m256 y = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(r0, r1, 0x24), r2, 0x49), y_order);
+        __m256 z = _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(r0, r1, 0x49), r2, 0x92), z_order);
+
+        r0 = _mm256_loadu_ps(e + 3 * i);
+        r1 = _mm256_loadu_ps(e + 3 * i + 8);
+        r2 = _mm256_loadu_ps(e + 3 * i + 16);
+
+        __m256 reach_x = _mm256_add_ps(extent_x, _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(r0, r1, 0x92), r2, 0x24), x_order));
+        __m256 reach_y = _mm256_add_ps(extent_y, _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(r0, r1, 0x24), r2, 0x49), y_order));
+        __m256 reach_z = _mm256_add_ps(extent_z, _mm256_permutevar8x32_ps(_mm256_blend_ps(_mm256_blend_ps(r0, r1, 0x49), r2, 0x92), z_order));
+
+        __m256 delta_x = _mm256_sub_ps(x, center_x);
+        __m256 delta_y = _mm256_sub_ps(y, center_y);
+        __m256 delta_z = _mm256_sub_ps(z, center_z);
+
+        __m256 overlap_x = _mm256_sub_ps(reach_x, _mm256_andnot_ps(sign_bit, delta_x));
+        __m256 overlap_y = _mm256_sub_ps(reach_y, _mm256_andnot_ps(sign_bit, delta_y));
+        __m256 overlap_z = _mm256_sub_ps(reach_z, _mm256_andnot_ps(sign_bit, delta_z));
+
+        // Same selects as find_box_contact(), one mask per comparison.
+        __m256 y_less = _mm256_cmp_ps(overlap_y, overlap_x, _CMP_LT_OQ);
+        __m256 depth  = _mm256_blendv_ps(overlap_x, overlap_y, y_less);
+        __m256 along  = _mm256_blendv_ps(delta_x, delta_y, y_less);
+        __m256 axis   = _mm256_and_ps(axis_y, y_less);
+
+        __m256 z_less = _mm256_cmp_ps(overlap_z, depth, _CMP_LT_OQ);
+        depth = _mm256_blendv_ps(depth, overlap_z, z_less);
+        along = _mm256_blendv_ps(along, delta_z, z_less);
+        axis  = _mm256_blendv_ps(axis, axis_z, z_less);
+
+        __m256 direction = _mm256_blendv_ps(minus, plus, _mm256_cmp_ps(along, zero, _CMP_GE_OQ));
+
+        _mm256_storeu_ps(depths + i, depth);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(axes + i), _mm256_castps_si256(axis));
+        _mm256_storeu_ps(directions + i, direction);
+    }
+
+    // Finished here rather than by calling find_box_contacts_scalar(), which
+    // compilers may turn into a jump that skips clearing the upper register
+    // halves, and the legacy SSE code after it then pays for the transition.
+    for (; i < count; i++)
+    {
+        BoxContact contact = find_box_contact(center, candidates[i], half_extents + candidate_half_extents[i]);
+        depths[i]     = contact.depth;
+        axes[i]       = contact.axis;
+        directions[i] = contact.direction;
+    }
+}
+
+#endif
\ No newline at end of file
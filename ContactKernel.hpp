@@ -0,0 +1,67 @@
+#pragma once
+#include "IntegrationKernel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+/// <summary>
+/// How two axis aligned boxes touch, along the axis they overlap least on.
+/// </summary>
+struct BoxContact
+{
+    float   depth;     // overlap along axis, <= 0 when the boxes don't touch
+    int32_t axis;      // 0 = x, 1 = y, 2 = z, the lowest one on ties
+    float   direction; // +1 if the other box is on the positive side of this one along axis, -1 if not
+};
+
+/// <summary>
+/// One box against one other box. half_extent_sum is the sum of both boxes'
+/// half extents. No branches, the axis and direction come from selects.
+/// </summary>
+inline BoxContact find_box_contact(const glm::vec3& center, const glm::vec3& other_center, const glm::vec3& half_extent_sum)
+{
+    glm::vec3 delta   = other_center - center;
+    glm::vec3 overlap = half_extent_sum - glm::abs(delta);
+
+    bool  y_less = overlap.y < overlap.x;
+    float depth  = y_less ? overlap.y : overlap.x;
+    float along  = y_less ? delta.y : delta.x;
+    int   axis   = y_less ? 1 : 0;
+
+    bool z_less = overlap.z < depth;
+    depth = z_less ? overlap.z : depth;
+    along = z_less ? delta.z : along;
+    axis  = z_less ? 2 : axis;
+
+    return { depth, axis, (along >= 0.0f) ? 1.0f : -1.0f };
+}
+
+/// <summary>
+/// One box against count others, results written to depths, axes and
+/// directions by candidate index, see BoxContact. Picks the widest kernel
+/// this CPU supports the first time it is called.
+/// </summary>
+void find_box_contacts(const glm::vec3& center, const glm::vec3& half_extents, const glm::vec3* candidates,
+                       const glm::vec3* candidate_half_extents, size_t count, float* depths, int32_t* axes, float* directions);
+
+/// <summary>
+/// find_box_contact() on each candidate in turn. The vector kernels give
+/// bit-identical results.
+/// </summary>
+void find_box_contacts_scalar(const glm::vec3& center, const glm::vec3& half_extents, const glm::vec3* candidates,
+                              const glm::vec3* candidate_half_extents, size_t count, float* depths, int32_t* axes, float* directions);
+
+#ifdef PHYS_X86
+/// <summary>
+/// Eight candidates per instruction. Only call this if cpu_supports_avx2() is true.
+/// </summary>
+void find_box_contacts_avx2(const glm::vec3& center, const glm::vec3& half_extents, const glm::vec3* candidates,
+                            const glm::vec3* candidate_half_extents, size_t count, float* depths, int32_t* axes, float* directions);
+#endif
+
+}
\ No newline at end of file
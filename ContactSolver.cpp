@@ -0,0 +1,162 @@
+#include "ContactSolver.hpp"
+
+bool phys::ContactSolver::key_less(const CachedImpulse& a, const CachedImpulse& b)
+{
+    return std::tie(a.id_a, a.id_b, a.b_is_dynamic) < std::tie(b.id_a, b.id_b, b.b_is_dynamic);
+}
+
+float phys::ContactSolver::find_cached_impulse(const Contact& contact) const
+{
+    CachedImpulse key  = { contact.id_a, contact.id_b, contact.body_b != INVALID_HANDLE, 0.0f };
+    auto          found = std::lower_bound(cache.begin(), cache.end(), key, key_less);
+    if (found != cache.end() and not key_less(key, *found))
+    {
+        return found->impulse;
+    }
+    return 0.0f;
+}
+
+std::vector<phys::Contact>& phys::ContactSolver::get_contacts()
+{
+    return contacts;
+}
+
+const std::vector<phys::Contact>& phys::ContactSolver::get_contacts() const
+{
+    return contacts;
+}
+
+void phys::ContactSolver::clear()
+{
+    contacts.clear();
+}
+
+void phys::ContactSolver::solve(glm::vec3* velocities, glm::vec3* push_velocities, const float* masses, float delta_time)
+{
+    // Targets come from the velocities before any impulse is applied. Working
+    // them out during the warm start would see one contact's warm start as
+    // the next one's approach, and bounce it.
+    for (Contact& contact : contacts)
+    {
+        bool      b_is_dynamic = contact.body_b != INVALID_HANDLE;
+        float     inverse_a    = 1.0f / masses[contact.body_a];
+        float     inverse_b    = b_is_dynamic ? 1.0f / masses[contact.body_b] : 0.0f;
+        glm::vec3 velocity_b   = b_is_dynamic ? velocities[contact.body_b] : glm::vec3(0.0f);
+
+        contact.mass_normal = 1.0f / (inverse_a + inverse_b);
+
+        // Bounce if the bodies came together fast enough, otherwise just stop.
+        float separating_speed = glm::dot(velocity_b - velocities[contact.body_a], contact.normal);
+        contact.target_speed   = (separating_speed < -RESTITUTION_THRESHOLD) ? -restitution * separating_speed : 0.0f;
+        contact.push_speed     = BAUMGARTE / delta_time * std::max(0.0f, contact.depth - PENETRATION_SLOP);
+
+        contact.impulse      = find_cached_impulse(contact);
+        contact.push_impulse = 0.0f;
+
+        push_velocities[contact.body_a] = glm::vec3(0.0f);
+        if (b_is_dynamic)
+        {
+            push_velocities[contact.body_b] = glm::vec3(0.0f);
+        }
+    }
+
+    // Applying last tick's impulses up front means a resting contact starts
+    // out already holding its body up.
+    for (const Contact& contact : contacts)
+    {
+        glm::vec3 impulse = contact.normal * contact.impulse;
+        velocities[contact.body_a] -= impulse / masses[contact.body_a];
+        if (contact.body_b != INVALID_HANDLE)
+        {
+            velocities[contact.body_b] += impulse / masses[contact.body_b];
+        }
+    }
+
+    // One pass over every contact, nudging its accumulated impulse towards
+    // the one that gives the target separating speed. Clamping the total
+    // rather than the change lets later passes take back some of what earlier
+    // ones applied, but contacts can only ever push.
+    auto iterate = [&](glm::vec3* speeds, float Contact::* target, float Contact::* accumulated)
+    {
+        for (Contact& contact : contacts)
+        {
+            bool      b_is_dynamic = contact.body_b != INVALID_HANDLE;
+            glm::vec3 speed_b      = b_is_dynamic ? speeds[contact.body_b] : glm::vec3(0.0f);
+
+            float separating_speed = glm::dot(speed_b - speeds[contact.body_a], contact.normal);
+            float change           = contact.mass_normal * (contact.*target - separating_speed);
+
+            float previous         = contact.*accumulated;
+            contact.*accumulated   = std::max(previous + change, 0.0f);
+            change                 = contact.*accumulated - previous;
+
+            glm::vec3 impulse = contact.normal * change;
+            speeds[contact.body_a] -= impulse / masses[contact.body_a];
+            if (b_is_dynamic)
+            {
+                speeds[contact.body_b] += impulse / masses[contact.body_b];
+            }
+        }
+    };
+
+    for (uint32_t iteration = 0; iteration < iterations; iteration++)
+    {
+        iterate(velocities, &Contact::target_speed, &Contact::impulse);
+    }
+    for (uint32_t iteration = 0; iteration < iterations; iteration++)
+    {
+        iterate(push_velocities, &Contact::push_speed, &Contact::push_impulse);
+    }
+
+    next_cache.clear();
+    next_cache.reserve(contacts.size());
+    for (const Contact& contact : contacts)
+    {
+        next_cache.push_back({ contact.id_a, contact.id_b, contact.body_b != INVALID_HANDLE, contact.impulse });
+    }
+    std::sort(next_cache.begin(), next_cache.end(), key_less);
+    std::swap(cache, next_cache);
+}
+
+void phys::ContactSolver::reset_cache()
+{
+    cache.clear();
+}
+
+void phys::ContactSolver::save(SnapshotWriter& writer) const
+{
+    writer.write_vector(cache);
+}
+
+void phys::ContactSolver::load(SnapshotReader& reader)
+{
+    reader.read_vector(cache);
+
+    // Lookups binary search the cache.
+    bool valid = std::is_sorted(cache.begin(), cache.end(), key_less) and
+                 std::all_of(cache.begin(), cache.end(), [](const CachedImpulse& entry) { return entry.b_is_dynamic <= 1; });
+    if (not valid)
+    {
+        throw std::runtime_error("phys::ContactSolver::load() failed. The cached impulses are out of order.");
+    }
+}
+
+void phys::ContactSolver::set_iterations(uint32_t count)
+{
+    iterations = count;
+}
+
+uint32_t phys::ContactSolver::get_iterations() const
+{
+    return iterations;
+}
+
+void phys::ContactSolver::set_restitution(float value)
+{
+    restitution = std::clamp(value, 0.0f, 1.0f);
+}
+
+float phys::ContactSolver::get_restitution() const
+{
+    return restitution;
+}
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include "PagedSparseArray.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+/// <summary>
+/// A dynamic body touching either another dynamic body or a static. Boxes
+/// never rotate, so a single point along one face normal is the whole manifold.
+/// </summary>
+struct Contact
+{
+    uint32_t  body_a;       // dense index of the dynamic body
+    uint32_t  body_b;       // dense index of the other dynamic body, INVALID_HANDLE for a static
+    uint32_t  id_a;         // DynamicID of body_a
+    uint32_t  id_b;         // DynamicID of body_b, or the StaticID
+    glm::vec3 normal;       // unit axis pointing from a to b
+    float     depth;        // penetration along normal
+    int       axis;         // axis the normal lies on, 0 = x, 1 = y, 2 = z
+
+    // Filled in by ContactSolver::solve().
+    float     mass_normal  = 0.0f; // 1 / (inverse mass of a + inverse mass of b)
+    float     target_speed = 0.0f; // separating speed the velocity pass drives the contact towards
+    float     push_speed   = 0.0f; // separating speed the push pass drives the contact towards
+    float     impulse      = 0.0f; // accumulated along normal, never negative
+    float     push_impulse = 0.0f; // same, for the push pass
+};
+
+/// <summary>
+/// Sequential impulse solver with warm starting. Every contact remembers the
+/// impulse it ended the last tick with, keyed by the IDs of the two objects,
+/// and starts from it the next tick. A resting stack then only has to correct
+/// what changed since the last tick, so a few iterations keep it still.
+///
+/// Penetration is pushed out by a second set of iterations on separate push
+/// velocities, which move the bodies this tick and are then thrown away. Had
+/// the push gone into the real velocities, a squashed stack would keep the
+/// speed it was pushed apart with and spring up off the floor.
+/// </summary>
+class ContactSolver
+{
+  private:
+    struct CachedImpulse
+    {
+        uint32_t id_a;
+        uint32_t id_b;
+        uint32_t b_is_dynamic; // 0 or 1, not a bool so there are no padding bytes to differ between snapshots
+        float    impulse;
+    };
+
+    std::vector<Contact>       contacts{};
+    std::vector<CachedImpulse> cache{};      // last tick's impulses, sorted by key
+    std::vector<CachedImpulse> next_cache{}; // built while solving, swapped with cache at the end
+
+    uint32_t iterations  = 8;
+    float    restitution = 0.6f;
+
+    static bool key_less(const CachedImpulse& a, const CachedImpulse& b);
+
+    float find_cached_impulse(const Contact& contact) const;
+
+  public:
+    // Fraction of the penetration beyond PENETRATION_SLOP pushed out per tick.
+    // Pushing all of it out at once overshoots, the rest follows over the next ticks.
+    static constexpr float BAUMGARTE             = 0.2f;
+    static constexpr float PENETRATION_SLOP      = 0.01f;
+    // Contacts approaching slower than this don't bounce. Otherwise resting
+    // bodies keep hopping off whatever they rest on.
+    static constexpr float RESTITUTION_THRESHOLD = 1.0f;
+
+    /// <summary>
+    /// Contacts to solve this tick. Cleared by clear(), filled by the caller.
+    /// </summary>
+    std::vector<Contact>& get_contacts();
+
+    const std::vector<Contact>& get_contacts() const;
+
+    void clear();
+
+    /// <summary>
+    /// Warm starts every contact from its cached impulse, then runs the
+    /// iterations on the velocities and on the push velocities. Caches the
+    /// final impulses for the next call, forgetting pairs that didn't touch
+    /// this tick.
+    /// </summary>
+    /// <param name="velocities">: indexed by the dense indices in the contacts</param>
+    /// <param name="push_velocities">: same indexing, only the entries of bodies in a contact are written, zeroed first</param>
+    /// <param name="masses">: same indexing, every mass > 0</param>
+    void solve(glm::vec3* velocities, glm::vec3* push_velocities, const float* masses, float delta_time);
+
+    /// <summary>
+    /// Forgets every cached impulse.
+    /// </summary>
+    void reset_cache();
+
+    /// <summary>
+    /// Appends the cached impulses to the writer, the only state kept between ticks.
+    /// </summary>
+    void save(SnapshotWriter& writer) const;
+
+    /// <summary>
+    /// Replaces the cached impulses with what save() wrote. Throws if they
+    /// aren't in the order lookups rely on.
+    /// </summary>
+    void load(SnapshotReader& reader);
+
+    void set_iterations(uint32_t count);
+
+    uint32_t get_iterations() const;
+
+    /// <summary>
+    /// Fraction of the approach speed a contact bounces back with, in [0, 1].
+    /// </summary>
+    void set_restitution(float value);
+
+    float get_restitution() const;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "PhysicsSystem.hpp"
+#include "SceneLoader.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Runs the simulation without a window or GL context:
+//   physics-headless [scene file] [ticks] [tick rate] [threads]
+// Every tick is stepped back to back as fast as possible and the throughput
+// is reported at the end.
+int main(int argc, char** argv)
+{
+    try
+    {
+        const char* scene_path   = (argc > 1) ? argv[1] : "scenes/default.scene";
+        size_t      tick_count   = (argc > 2) ? std::stoul(argv[2]) : 1000;
+        double      tick_rate    = (argc > 3) ? std::stod(argv[3]) : 60.0; // in updates/sec
+        size_t      thread_count = (argc > 4) ? std::stoul(argv[4]) : 0;   // 0 = every core
+
+        std::shared_ptr<phys::JobSystem>     job_system     = std::make_shared<phys::JobSystem>(thread_count);
+        std::shared_ptr<phys::PhysicsSystem> physics_system = std::make_shared<phys::PhysicsSystem>(job_system);
+
+        phys::SceneStats stats = phys::load_scene(scene_path, *physics_system);
+
+        const double tick_duration = 1.0 / tick_rate;
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (size_t tick = 0; tick < tick_count; tick++)
+        {
+            physics_system->step(tick_duration);
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+
+        double seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+        std::cout << std::format("scene:          {} ({} static, {} dynamic)", scene_path, stats.static_count, stats.dynamic_count) << std::endl;
+        std::cout << std::format("threads:        {}", job_system->get_thread_count()) << std::endl;
+        std::cout << std::format("ticks:          {} at {} Hz", tick_count, tick_rate) << std::endl;
+        std::cout << std::format("wall time:      {:.3f} s", seconds) << std::endl;
+        std::cout << std::format("ms per tick:    {:.4f}", seconds * 1000.0 / tick_count) << std::endl;
+        std::cout << std::format("ticks/s:        {:.1f}", tick_count / seconds) << std::endl;
+        std::cout << std::format("bodies/s:       {:.0f}", (stats.dynamic_count * tick_count) / seconds) << std::endl;
+        std::cout << std::format("realtime ratio: {:.2f}x", (tick_count * tick_duration) / seconds) << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#include "IntegrationKernel.hpp"
+
+#ifdef PHYS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// The scalar kernel must not be contracted into fused multiply-adds, or it would
+// stop matching the vector kernel bit for bit. MSVC's default /fp:precise and
+// GCC/Clang with -ffp-contract=off both leave it alone.
+
+namespace
+{
+
+inline void integrate_body(glm::vec3& position, glm::vec3& velocity, glm::vec3& force, float mass,
+                           const glm::vec3& gravity, float delta_time)
+{
+    // Accumulate gravity as a force. other forces (like thrust,
+    // collisions, etc.) are added elsewhere
+    force += mass * gravity;
+
+    // Newton's second law: a = f/m
+    // Integrates acceleration into velocity. This is the semi - implicit
+    // Euler method, which is more stable than simple(explicit) Euler.
+    velocity += (force / mass) * delta_time;
+
+    position += velocity * delta_time;
+
+    force = glm::vec3(0.0f);
+}
+
+using IntegrateFunction = void (*)(glm::vec3*, glm::vec3*, glm::vec3*, const float*, size_t, const glm::vec3&, float);
+
+IntegrateFunction select_kernel()
+{
+#ifdef PHYS_X86
+    if (phys::cpu_supports_avx2())
+    {
+        return phys::integrate_bodies_avx2;
+    }
+#endif
+    return phys::integrate_bodies_scalar;
+}
+
+}
+
+void phys::integrate_bodies(glm::vec3* positions, glm::vec3* velocities, glm::vec3* forces, const float* masses,
+                            size_t count, const glm::vec3& gravity, float delta_time)
+{
+    static const IntegrateFunction kernel = select_kernel();
+    kernel(positions, velocities, forces, masses, count, gravity, delta_time);
+}
+
+void phys::integrate_bodies_scalar(glm::vec3* positions, glm::vec3* velocities, glm::vec3* forces, const float* masses,
+                                   size_t count, const glm::vec3& gravity, float delta_time)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        integrate_body(positions[i], velocities[i], forces[i], masses[i], gravity, delta_time);
+    }
+}
+
+#ifdef PHYS_X86
+
+PHYS_TARGET_AVX2
+void phys::integrate_bodies_avx2(glm::vec3* positions, glm::vec3* velocities, glm::vec3* forces, const float* masses,
+                                 size_t count, const glm::vec3& gravity, float delta_time)
+{
+    // Eight packed vec3s are 24 floats, i.e. three registers per field. Lane k of
+    // register r holds component (8r + k) % 3 of body (8r + k) / 3.
+    const __m256i body_of_lane[3] =
+    {
+        _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2),
+        _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5),
+        _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7)
+    };
+    const __m256 gravity_lanes[3] =
+    {
+        _mm256_setr_ps(gravity.x, gravity.y, gravity.z, gravity.x, gravity.y, gravity.z, gravity.x, gravity.y),
+        _mm256_setr_ps(gravity.z, gravity.x, gravity.y, gravity.z, gravity.x, gravity.y, gravity.z, gravity.x),
+        _mm256_setr_ps(gravity.y, gravity.z, gravity.x, gravity.y, gravity.z, gravity.x, gravity.y, gravity.z)
+    };
+    const __m256 dt   = _mm256_set1_ps(delta_time);
+    const __m256 zero = _mm256_setzero_ps();
+
+    float* p = &positions[0].x;
+    float* v = &velocities[0].x;
+    float* f = &forces[0].x;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 mass8 = _mm256_loadu_ps(masses + i);
+
+        for (int r = 0; r < 3; r++)
+        {
+            size_t offset = 3 * i + 8 * r;
+
+            __m256 mass     = _mm256_permutevar8x32_ps(mass8, body_of_lane[r]);
+            __m256 force    = _mm256_loadu_ps(f + offset);
+            __m256 velocity = _mm256_loadu_ps(v + offset);
+            __m256 position = _mm256_loadu_ps(p + offset);
+
+            force    = _mm256_add_ps(force, _mm256_mul_ps(mass, gravity_lanes[r]));
+            velocity = _mm256_add_ps(velocity, _mm256_mul_ps(_mm256_div_ps(force, mass), dt));
+            position = _mm256_add_ps(position, _mm256_mul_ps(velocity, dt));
+
+            _mm256_storeu_ps(v + offset, velocity);
+            _mm256_storeu_ps(p + offset, position);
+            _mm256_storeu_ps(f + offset, zero);
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        integrate_body(positions[i], velocities[i], forces[i], masses[i], gravity, delta_time);
+    }
+}
+
+bool phys::cpu_supports_avx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // The OS also has to save the upper halves of the ymm registers on context switches.
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) != 0 and (_xgetbv(0) & 0x6) == 0x6;
+
+    __cpuidex(info, 7, 0);
+    bool has_avx2 = (info[1] & (1 << 5)) != 0;
+
+    return os_saves_ymm and has_avx2;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#else
+
+bool phys::cpu_supports_avx2()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHYS_X86 1
+#endif
+
+// MSVC compiles AVX2 intrinsics anywhere; GCC and Clang need the function marked.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define PHYS_TARGET_AVX2
+#else
+#define PHYS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace phys
+{
+
+/// <summary>
+/// Semi-implicit Euler over a run of bodies stored as a structure of arrays:
+/// adds gravity to the force, integrates force into velocity and velocity into
+/// position, then clears the force. Picks the widest kernel this CPU supports
+/// the first time it is called.
+/// </summary>
+void integrate_bodies(glm::vec3* positions, glm::vec3* velocities, glm::vec3* forces, const float* masses,
+                      size_t count, const glm::vec3& gravity, float delta_time);
+
+/// <summary>
+/// One body at a time. Performs exactly the same float operations in the same
+/// order as the vector kernels, so results are bit-identical between them.
+/// </summary>
+void integrate_bodies_scalar(glm::vec3* positions, glm::vec3* velocities, glm::vec3* forces, const float* masses,
+                             size_t count, const glm::vec3& gravity, float delta_time);
+
+#ifdef PHYS_X86
+/// <summary>
+/// Eight bodies per instruction. Only call this if cpu_supports_avx2() is true.
+/// </summary>
+void integrate_bodies_avx2(glm::vec3* positions, glm::vec3* velocities, glm::vec3* forces, const float* masses,
+                           size_t count, const glm::vec3& gravity, float delta_time);
+#endif
+
+bool cpu_supports_avx2();
+
+}
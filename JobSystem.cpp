@@ -0,0 +1,165 @@
+#include "JobSystem.hpp"
+
+phys::JobSystem::JobSystem(size_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (size_t worker = 1; worker < thread_count; worker++)
+    {
+        threads.emplace_back(&JobSystem::worker_loop, this, worker);
+    }
+}
+
+phys::JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        running = false;
+    }
+    sleep_condition.notify_all();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+size_t phys::JobSystem::get_thread_count() const
+{
+    return queues.size();
+}
+
+bool phys::JobSystem::pop(size_t worker, Job& job)
+{
+    WorkerQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+    {
+        return false;
+    }
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    queued--;
+    return true;
+}
+
+bool phys::JobSystem::steal(size_t worker, Job& job)
+{
+    for (size_t offset = 1; offset < queues.size(); offset++)
+    {
+        WorkerQueue& victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (not victim.jobs.empty())
+        {
+            // Steal from the opposite end to the owner to keep contention down.
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void phys::JobSystem::run(const Job& job, size_t worker)
+{
+    Batch& batch = *job.batch;
+    if (not batch.failed.load(std::memory_order_relaxed))
+    {
+        try
+        {
+            (*batch.body)({ job.begin, job.end, job.chunk, worker });
+        }
+        catch (...)
+        {
+            if (not batch.failed.exchange(true))
+            {
+                batch.error = std::current_exception();
+            }
+        }
+    }
+
+    // Always counted, parallel_for can't return while a job still points at its batch.
+    batch.remaining.fetch_sub(1, std::memory_order_release);
+}
+
+void phys::JobSystem::worker_loop(size_t worker)
+{
+    while (running)
+    {
+        Job job;
+        if (pop(worker, job) or steal(worker, job))
+        {
+            run(job, worker);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_condition.wait(lock, [this] { return not running or queued > 0; });
+    }
+}
+
+void phys::JobSystem::parallel_for(size_t count, size_t chunk_size, const std::function<void(const JobRange&)>& body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    // Nothing to share, skip the queues entirely.
+    if (queues.size() == 1 or chunk_count == 1)
+    {
+        for (size_t chunk = 0; chunk < chunk_count; chunk++)
+        {
+            body({ chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size), chunk, 0 });
+        }
+        return;
+    }
+
+    Batch batch;
+    batch.body      = &body;
+    batch.remaining = chunk_count;
+
+    // Deal the chunks out round robin so every worker starts with local work.
+    for (size_t chunk = 0; chunk < chunk_count; chunk++)
+    {
+        Job job = { &batch, chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size), chunk };
+        WorkerQueue& queue = *queues[chunk % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_condition.notify_all();
+
+    while (batch.remaining.load(std::memory_order_acquire) > 0)
+    {
+        Job job;
+        if (pop(0, job) or steal(0, job))
+        {
+            run(job, 0);
+        }
+        else
+        {
+            // Only the last few chunks are still running elsewhere.
+            std::this_thread::yield();
+        }
+    }
+
+    if (batch.error)
+    {
+        std::rethrow_exception(batch.error);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+namespace phys
+{
+
+/// <summary>
+/// The slice of a parallel_for handed to one call of its body.
+/// </summary>
+struct JobRange
+{
+    size_t begin;  // first index, inclusive
+    size_t end;    // last index, exclusive
+    size_t chunk;  // begin / chunk_size, stable no matter which thread runs it
+    size_t worker; // index of the thread running it, in [0, get_thread_count())
+};
+
+/// <summary>
+/// Fixed pool of worker threads with one job queue each. A worker takes jobs
+/// from the back of its own queue and, once that is empty, steals from the
+/// front of the others, so uneven chunks still keep every core busy.
+/// </summary>
+class JobSystem
+{
+  private:
+    // Shared by every job of one parallel_for, lives on its caller's stack.
+    struct Batch
+    {
+        const std::function<void(const JobRange&)>* body;
+        std::atomic<size_t>                         remaining;
+        std::atomic<bool>                           failed = false;
+        std::exception_ptr                          error  = nullptr; // the first exception a body threw
+    };
+
+    struct Job
+    {
+        Batch* batch;
+        size_t begin;
+        size_t end;
+        size_t chunk;
+    };
+
+    struct WorkerQueue
+    {
+        std::deque<Job> jobs;
+        std::mutex      mutex;
+    };
+
+    // Queue 0 belongs to whichever thread calls parallel_for, the rest to the pool.
+    std::vector<std::unique_ptr<WorkerQueue>> queues{};
+    std::vector<std::thread>                  threads{};
+
+    std::atomic<bool>       running = true;
+    std::atomic<size_t>     queued  = 0; // jobs sitting in any queue
+    std::mutex              sleep_mutex{};
+    std::condition_variable sleep_condition{};
+
+    bool pop(size_t worker, Job& job);
+
+    bool steal(size_t worker, Job& job);
+
+    void run(const Job& job, size_t worker);
+
+    void worker_loop(size_t worker);
+
+  public:
+    /// <param name="thread_count">: total threads including the caller. 0 uses every core.</param>
+    JobSystem(size_t thread_count = 0);
+
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    size_t get_thread_count() const;
+
+    /// <summary>
+    /// Splits [0, count) into chunks of chunk_size and runs body on each chunk
+    /// across the pool. The calling thread helps out and this returns once every
+    /// chunk has finished. If a body throws, chunks not yet started are skipped
+    /// and the first exception is rethrown here once the rest have finished.
+    /// Must not be called from inside a body.
+    /// </summary>
+    void parallel_for(size_t count, size_t chunk_size, const std::function<void(const JobRange&)>& body);
+};
+
+}
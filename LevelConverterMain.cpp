@@ -0,0 +1,135 @@
+#include "LevelFile.hpp"
+#include "PhysicsSystem.hpp"
+#include "SceneLoader.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Turns a text level into a level file (see LevelFile.hpp) offline, so the
+// app and tools never parse one at startup:
+//   level-converter <text level> <level file>
+// One entry per line, fields separated by spaces or commas so spreadsheets can
+// export straight to it. Blank lines and lines starting with '#' are skipped:
+//   broadphase bvh|spatial_hash|voxel_grid [ox oy oz]  at most once, bvh if missing
+//   [static] x y z [shape hx hy hz]                    one static, as in a scene file
+// ox oy oz is the voxel grid offset. With the BVH the tree is built here and
+// stored in the file.
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc != 3)
+        {
+            std::cerr << "usage: level-converter <text level> <level file>" << std::endl;
+            return EXIT_FAILURE;
+        }
+        const char* input_path  = argv[1];
+        const char* output_path = argv[2];
+
+        std::ifstream input(input_path);
+        if (not input)
+        {
+            throw std::runtime_error(std::format("level-converter failed. Could not open {}", input_path));
+        }
+
+        std::vector<phys::StaticObject> statics;
+        phys::StaticBroadphase          broadphase     = phys::StaticBroadphase::bvh;
+        glm::vec3                       voxel_offset   = glm::vec3(0.0f);
+        bool                            has_broadphase = false;
+        std::string                     line;
+        size_t                          line_number = 0;
+
+        while (std::getline(input, line))
+        {
+            line_number++;
+            std::replace(line.begin(), line.end(), ',', ' ');
+
+            std::istringstream stream(line);
+            std::string first;
+            if (not (stream >> first) or first[0] == '#')
+            {
+                continue;
+            }
+
+            bool valid = false;
+            if (first == "broadphase")
+            {
+                std::string name;
+                stream >> name;
+                valid = not has_broadphase;
+                if (name == "bvh")
+                {
+                    broadphase = phys::StaticBroadphase::bvh;
+                }
+                else if (name == "spatial_hash")
+                {
+                    broadphase = phys::StaticBroadphase::spatial_hash;
+                }
+                else if (name == "voxel_grid")
+                {
+                    broadphase = phys::StaticBroadphase::voxel_grid;
+                    if (not (stream >> voxel_offset.x >> voxel_offset.y >> voxel_offset.z))
+                    {
+                        voxel_offset = glm::vec3(0.0f);
+                    }
+                }
+                else
+                {
+                    valid = false;
+                }
+                has_broadphase = true;
+            }
+            else
+            {
+                // Without the keyword the line is a bare row of numbers.
+                if (first != "static")
+                {
+                    stream.clear();
+                    stream.seekg(0);
+                }
+                phys::StaticObject object = {};
+                glm::vec3&         pos    = object.position;
+                valid = stream >> pos.x >> pos.y >> pos.z and phys::read_shape(stream, object.shape, object.half_extents)
+                        and phys::is_valid_shape(object.shape, object.half_extents);
+                if (valid)
+                {
+                    statics.push_back(object);
+                }
+            }
+
+            if (not valid)
+            {
+                throw std::runtime_error(std::format("level-converter failed. {} line {} is not a valid entry: {}",
+                                                     input_path, line_number, line));
+            }
+        }
+
+        // Catches statics the broadphase can't hold (e.g. off the voxel grid)
+        // now, rather than when the level is first loaded.
+        phys::PhysicsSystem         check_system(std::make_shared<phys::JobSystem>(1));
+        std::vector<phys::StaticID> ids;
+        check_system.set_static_broadphase(broadphase, voxel_offset);
+        check_system.add_statics(statics, ids);
+
+        phys::write_level(output_path, statics, broadphase, voxel_offset);
+
+        phys::LevelFile level(output_path);
+        std::cout << std::format("{}: {} statics, {} prebuilt BVH nodes", output_path, level.get_statics().size(),
+                                 level.get_bvh_nodes().size()) << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
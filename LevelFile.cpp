@@ -0,0 +1,225 @@
+#include "LevelFile.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <format>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+// Maps the whole file read only. Returns null if it can't, or if the file is
+// empty, which can't be mapped. The mapping outlives the handles used to make it.
+const std::byte* map_file(const char* filepath, size_t& size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    LARGE_INTEGER file_size;
+    void*         view = nullptr;
+    if (GetFileSizeEx(file, &file_size) and file_size.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        size = size_t(file_size.QuadPart);
+    }
+    CloseHandle(file);
+    return static_cast<const std::byte*>(view);
+#else
+    int descriptor = open(filepath, O_RDONLY);
+    if (descriptor == -1)
+    {
+        return nullptr;
+    }
+
+    struct stat status;
+    void*       view = MAP_FAILED;
+    if (fstat(descriptor, &status) == 0 and status.st_size > 0)
+    {
+        size = size_t(status.st_size);
+        view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+    close(descriptor);
+    return (view == MAP_FAILED) ? nullptr : static_cast<const std::byte*>(view);
+#endif
+}
+
+void unmap_file(const std::byte* data, size_t size)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<std::byte*>(data), size);
+#endif
+}
+
+// Whether count records of record_size bytes fit in the file at offset.
+bool is_section_valid(uint64_t offset, uint64_t count, size_t record_size, size_t header_size, size_t file_size)
+{
+    return offset % phys::LEVEL_SECTION_ALIGNMENT == 0 and offset >= header_size and offset <= file_size and
+           count <= (file_size - offset) / record_size;
+}
+
+uint64_t align_section(uint64_t offset)
+{
+    return (offset + phys::LEVEL_SECTION_ALIGNMENT - 1) / phys::LEVEL_SECTION_ALIGNMENT * phys::LEVEL_SECTION_ALIGNMENT;
+}
+
+}
+
+phys::LevelFile::LevelFile(const char* filepath)
+{
+    data = map_file(filepath, size);
+    if (data == nullptr)
+    {
+        throw std::runtime_error(std::format("phys::LevelFile::LevelFile() failed. Could not map {}", filepath));
+    }
+
+    header = reinterpret_cast<const LevelHeader*>(data);
+
+    const char* problem = nullptr;
+    if (size < sizeof(LevelHeader) or header->magic != LEVEL_MAGIC)
+    {
+        problem = "is not a level file";
+    }
+    else if (header->version != LEVEL_VERSION or header->header_size != sizeof(LevelHeader))
+    {
+        problem = "was written for a different version of the level format";
+    }
+    else if (header->broadphase > uint32_t(StaticBroadphase::voxel_grid))
+    {
+        problem = "names an unknown broadphase";
+    }
+    else if (not is_section_valid(header->statics_offset, header->static_count, sizeof(StaticObject), sizeof(LevelHeader), size) or
+             not is_section_valid(header->bvh_nodes_offset, header->bvh_node_count, sizeof(BVHNode), sizeof(LevelHeader), size))
+    {
+        problem = "has a section that is misaligned or runs past its end";
+    }
+
+    if (problem != nullptr)
+    {
+        unmap_file(data, size);
+        throw std::runtime_error(std::format("phys::LevelFile::LevelFile() failed. {} {}", filepath, problem));
+    }
+}
+
+phys::LevelFile::~LevelFile()
+{
+    unmap_file(data, size);
+}
+
+const phys::LevelHeader& phys::LevelFile::get_header() const
+{
+    return *header;
+}
+
+phys::StaticBroadphase phys::LevelFile::get_broadphase() const
+{
+    return StaticBroadphase(header->broadphase);
+}
+
+glm::vec3 phys::LevelFile::get_voxel_offset() const
+{
+    return glm::vec3(header->voxel_offset[0], header->voxel_offset[1], header->voxel_offset[2]);
+}
+
+std::span<const phys::StaticObject> phys::LevelFile::get_statics() const
+{
+    return { reinterpret_cast<const StaticObject*>(data + header->statics_offset), size_t(header->static_count) };
+}
+
+std::span<const phys::BVHNode> phys::LevelFile::get_bvh_nodes() const
+{
+    return { reinterpret_cast<const BVHNode*>(data + header->bvh_nodes_offset), size_t(header->bvh_node_count) };
+}
+
+int32_t phys::LevelFile::get_bvh_root() const
+{
+    return header->bvh_root;
+}
+
+void phys::load_level(const LevelFile& level, PhysicsSystem& physics_system, std::vector<StaticID>& ids)
+{
+    physics_system.set_static_broadphase(level.get_broadphase(), level.get_voxel_offset());
+
+    if (level.get_bvh_nodes().empty())
+    {
+        physics_system.add_statics(level.get_statics(), ids);
+    }
+    else
+    {
+        physics_system.add_statics(level.get_statics(), level.get_bvh_nodes(), level.get_bvh_root(), ids);
+    }
+}
+
+void phys::write_level(const char* filepath, std::span<const StaticObject> statics, StaticBroadphase broadphase,
+                       const glm::vec3& voxel_offset)
+{
+    StaticBVH bvh;
+    if (broadphase == StaticBroadphase::bvh)
+    {
+        // Handles are file indices, PhysicsSystem::add_statics() swaps in the real ones.
+        std::vector<BVHItem> items(statics.size());
+        for (size_t i = 0; i < statics.size(); i++)
+        {
+            items[i] = { uint32_t(i), statics[i].position - statics[i].half_extents, statics[i].position + statics[i].half_extents };
+        }
+        bvh.build(std::move(items));
+    }
+    const std::vector<BVHNode>& nodes = bvh.get_nodes();
+
+    LevelHeader header      = {};
+    header.magic            = LEVEL_MAGIC;
+    header.version          = LEVEL_VERSION;
+    header.header_size      = sizeof(LevelHeader);
+    header.broadphase       = uint32_t(broadphase);
+    header.voxel_offset[0]  = voxel_offset.x;
+    header.voxel_offset[1]  = voxel_offset.y;
+    header.voxel_offset[2]  = voxel_offset.z;
+    header.bvh_root         = bvh.get_root();
+    header.static_count     = statics.size();
+    header.statics_offset   = align_section(sizeof(LevelHeader));
+    header.bvh_node_count   = nodes.size();
+    header.bvh_nodes_offset = align_section(header.statics_offset + statics.size() * sizeof(StaticObject));
+
+    std::vector<std::byte> buffer(header.bvh_nodes_offset + nodes.size() * sizeof(BVHNode), std::byte(0));
+    std::memcpy(buffer.data(), &header, sizeof(LevelHeader));
+
+    // StaticObject has padding after its shape, which is left zeroed rather
+    // than copied so the same level always writes the same bytes.
+    constexpr size_t used_size = offsetof(StaticObject, shape) + sizeof(ShapeType);
+    for (size_t i = 0; i < statics.size(); i++)
+    {
+        std::memcpy(buffer.data() + header.statics_offset + i * sizeof(StaticObject), &statics[i], used_size);
+    }
+    if (not nodes.empty())
+    {
+        std::memcpy(buffer.data() + header.bvh_nodes_offset, nodes.data(), nodes.size() * sizeof(BVHNode));
+    }
+
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(buffer.data()), std::streamsize(buffer.size()));
+    if (not file)
+    {
+        throw std::runtime_error(std::format("phys::write_level() failed. Could not write {}", filepath));
+    }
+}
\ No newline at end of file
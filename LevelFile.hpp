@@ -0,0 +1,107 @@
+#pragma once
+#include "PhysicsSystem.hpp"
+#include "StaticBVH.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+// A level file is the static world exactly as PhysicsSystem holds it in
+// memory, so loading one is a map and a couple of bulk copies:
+//   LevelHeader
+//   StaticObject[static_count]  at statics_offset
+//   BVHNode[bvh_node_count]     at bvh_nodes_offset, optional
+// Sections start on LEVEL_SECTION_ALIGNMENT byte boundaries, padding is zero
+// and everything is little endian. Bump LEVEL_VERSION whenever the header or
+// either record changes layout, old files are then rejected rather than misread.
+constexpr uint32_t LEVEL_MAGIC             = 0x4C564C50; // "PLVL"
+constexpr uint32_t LEVEL_VERSION           = 1;
+constexpr uint64_t LEVEL_SECTION_ALIGNMENT = 16;
+
+struct LevelHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;      // sizeof(LevelHeader)
+    uint32_t broadphase;       // the StaticBroadphase the level was made for
+    float    voxel_offset[3];  // voxel grid only, see PhysicsSystem::set_static_broadphase()
+    int32_t  bvh_root;         // -1 without a prebuilt tree
+    uint64_t static_count;
+    uint64_t statics_offset;   // in bytes from the start of the file
+    uint64_t bvh_node_count;   // 0 without a prebuilt tree
+    uint64_t bvh_nodes_offset;
+};
+
+static_assert(std::endian::native == std::endian::little, "Level files are little endian and read in place.");
+static_assert(std::is_trivially_copyable_v<LevelHeader> and sizeof(LevelHeader) == 64);
+static_assert(std::is_trivially_copyable_v<StaticObject> and std::is_standard_layout_v<StaticObject> and sizeof(StaticObject) == 28);
+static_assert(std::is_trivially_copyable_v<BVHNode> and std::is_standard_layout_v<BVHNode> and sizeof(BVHNode) == 44);
+
+/// <summary>
+/// A level file mapped read only into memory. The header and section bounds
+/// are checked when it is opened; the records themselves are handed out in
+/// place and checked by whatever takes them, e.g. PhysicsSystem::add_statics().
+/// </summary>
+class LevelFile
+{
+  private:
+    const std::byte*   data   = nullptr;
+    size_t             size   = 0;
+    const LevelHeader* header = nullptr;
+
+  public:
+    /// <summary>
+    /// Throws if the file can't be mapped, or isn't a level file of LEVEL_VERSION
+    /// with every section inside it.
+    /// </summary>
+    explicit LevelFile(const char* filepath);
+
+    ~LevelFile();
+
+    LevelFile(const LevelFile&)            = delete;
+    LevelFile& operator=(const LevelFile&) = delete;
+
+    const LevelHeader& get_header() const;
+
+    StaticBroadphase get_broadphase() const;
+
+    glm::vec3 get_voxel_offset() const;
+
+    /// <summary>
+    /// Points into the mapping, valid as long as this LevelFile is.
+    /// </summary>
+    std::span<const StaticObject> get_statics() const;
+
+    /// <summary>
+    /// Empty if the level has no prebuilt tree. Leaf handles are indices into
+    /// get_statics(). Points into the mapping, valid as long as this LevelFile is.
+    /// </summary>
+    std::span<const BVHNode> get_bvh_nodes() const;
+
+    int32_t get_bvh_root() const;
+};
+
+/// <summary>
+/// Switches the physics system to the broadphase the level was made for and
+/// adds its statics, taking the prebuilt tree if there is one.
+/// </summary>
+/// <param name="ids">: the new statics' ids are appended, in file order</param>
+void load_level(const LevelFile& level, PhysicsSystem& physics_system, std::vector<StaticID>& ids);
+
+/// <summary>
+/// Writes statics to a level file, with a prebuilt tree when broadphase is
+/// the BVH. Throws if the file can't be written.
+/// </summary>
+/// <param name="voxel_offset">: stored for the voxel grid, see PhysicsSystem::set_static_broadphase()</param>
+void write_level(const char* filepath, std::span<const StaticObject> statics, StaticBroadphase broadphase,
+                 const glm::vec3& voxel_offset = glm::vec3(0.0f));
+
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "Log.hpp"
+
+namespace
+{
+
+const char* level_name(phys::LogLevel level)
+{
+    switch (level)
+    {
+        case phys::LogLevel::trace: return "trace";
+        case phys::LogLevel::debug: return "debug";
+        case phys::LogLevel::info:  return "info";
+        case phys::LogLevel::warn:  return "warn";
+        case phys::LogLevel::error: return "error";
+    }
+    return "?";
+}
+
+}
+
+phys::AsyncLog::AsyncLog()
+    :
+    slots(std::make_unique<Slot[]>(CAPACITY))
+{
+    for (size_t i = 0; i < CAPACITY; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    drain_thread = std::thread(&AsyncLog::drain_loop, this);
+}
+
+phys::AsyncLog::~AsyncLog()
+{
+    running = false;
+    drain_thread.join();
+}
+
+phys::AsyncLog& phys::AsyncLog::instance()
+{
+    static AsyncLog log;
+    return log;
+}
+
+phys::AsyncLog::Slot* phys::AsyncLog::claim(size_t& position)
+{
+    // Bounded multi-producer queue: a slot is free for the writer at 'position'
+    // once its sequence number has caught up to that position.
+    position = write_position.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot&     slot     = slots[position & (CAPACITY - 1)];
+        size_t    sequence = slot.sequence.load(std::memory_order_acquire);
+        ptrdiff_t lag      = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+
+        if (lag == 0)
+        {
+            if (write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                return &slot;
+            }
+        }
+        else if (lag < 0)
+        {
+            return nullptr; // the drain thread hasn't freed this slot yet, ring is full
+        }
+        else
+        {
+            position = write_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t phys::AsyncLog::drain(std::ostream& out)
+{
+    size_t count    = 0;
+    size_t position = read_position.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+        Slot& slot = slots[position & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+        {
+            break; // not written yet
+        }
+
+        const LogMessage& message = slot.message;
+        out << '[' << level_name(message.level) << "] ";
+        out.write(message.text, message.length);
+        out << '\n';
+
+        // Hand the slot back to the producers for the next lap around the ring.
+        slot.sequence.store(position + CAPACITY, std::memory_order_release);
+        position++;
+        count++;
+    }
+
+    read_position.store(position, std::memory_order_relaxed);
+
+    size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost > 0)
+    {
+        out << "[warn] log ring full, dropped " << lost << " messages\n";
+    }
+
+    if (count > 0 or lost > 0)
+    {
+        out.flush(); // once per batch, not per line
+    }
+    return count;
+}
+
+void phys::AsyncLog::drain_loop()
+{
+    while (running)
+    {
+        if (drain(std::cout) == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    drain(std::cout);
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <format>
+#include <iostream>
+
+// Log levels. Anything below PHYS_LOG_LEVEL is compiled out completely,
+// arguments included. Define PHYS_LOG_LEVEL in the project settings to override.
+#define PHYS_LOG_LEVEL_TRACE 0
+#define PHYS_LOG_LEVEL_DEBUG 1
+#define PHYS_LOG_LEVEL_INFO  2
+#define PHYS_LOG_LEVEL_WARN  3
+#define PHYS_LOG_LEVEL_ERROR 4
+#define PHYS_LOG_LEVEL_OFF   5
+
+#ifndef PHYS_LOG_LEVEL
+#ifdef NDEBUG
+#define PHYS_LOG_LEVEL PHYS_LOG_LEVEL_INFO
+#else
+#define PHYS_LOG_LEVEL PHYS_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+namespace phys
+{
+
+enum class LogLevel : int
+{
+    trace = PHYS_LOG_LEVEL_TRACE,
+    debug = PHYS_LOG_LEVEL_DEBUG,
+    info  = PHYS_LOG_LEVEL_INFO,
+    warn  = PHYS_LOG_LEVEL_WARN,
+    error = PHYS_LOG_LEVEL_ERROR
+};
+
+constexpr bool log_enabled(LogLevel level)
+{
+    return static_cast<int>(level) >= PHYS_LOG_LEVEL;
+}
+
+struct LogMessage
+{
+    LogLevel level;
+    uint32_t length;
+    char     text[248];
+};
+
+/// <summary>
+/// Log sink that never blocks the thread writing to it. Messages are formatted
+/// into slots of a fixed size lock-free ring buffer and a background thread
+/// drains them to stdout. If the ring is full the message is dropped and
+/// counted rather than waited on.
+/// </summary>
+class AsyncLog
+{
+  private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        LogMessage          message;
+    };
+
+    static constexpr size_t CAPACITY = 4096; // must be a power of two
+
+    std::unique_ptr<Slot[]> slots;
+
+    alignas(64) std::atomic<size_t> write_position = 0;
+    alignas(64) std::atomic<size_t> read_position  = 0;
+    alignas(64) std::atomic<size_t> dropped        = 0;
+
+    std::atomic<bool> running = true;
+    std::thread       drain_thread;
+
+    AsyncLog();
+
+    /// <summary>
+    /// Claims the next free slot, or returns nullptr if the ring is full.
+    /// </summary>
+    Slot* claim(size_t& position);
+
+    /// <summary>
+    /// Writes out everything currently in the ring. Only the drain thread calls this.
+    /// </summary>
+    size_t drain(std::ostream& out);
+
+    void drain_loop();
+
+  public:
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    static AsyncLog& instance();
+
+    template<typename... Args>
+    void write(LogLevel level, std::format_string<Args...> format, Args&&... args);
+};
+
+template<typename... Args>
+void AsyncLog::write(LogLevel level, std::format_string<Args...> format, Args&&... args)
+{
+    size_t position;
+    Slot*  slot = claim(position);
+    if (slot == nullptr)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    LogMessage& message = slot->message;
+    auto result = std::format_to_n(message.text, sizeof(message.text), format, std::forward<Args>(args)...);
+    message.level  = level;
+    message.length = static_cast<uint32_t>(result.out - message.text); // long messages are cut off
+
+    // Publish the slot to the drain thread.
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+}
+
+#if PHYS_LOG_LEVEL <= PHYS_LOG_LEVEL_TRACE
+#define PHYS_LOG_TRACE(...) ::phys::AsyncLog::instance().write(::phys::LogLevel::trace, __VA_ARGS__)
+#else
+#define PHYS_LOG_TRACE(...) ((void)0)
+#endif
+
+#if PHYS_LOG_LEVEL <= PHYS_LOG_LEVEL_DEBUG
+#define PHYS_LOG_DEBUG(...) ::phys::AsyncLog::instance().write(::phys::LogLevel::debug, __VA_ARGS__)
+#else
+#define PHYS_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if PHYS_LOG_LEVEL <= PHYS_LOG_LEVEL_INFO
+#define PHYS_LOG_INFO(...) ::phys::AsyncLog::instance().write(::phys::LogLevel::info, __VA_ARGS__)
+#else
+#define PHYS_LOG_INFO(...) ((void)0)
+#endif
+
+#if PHYS_LOG_LEVEL <= PHYS_LOG_LEVEL_WARN
+#define PHYS_LOG_WARN(...) ::phys::AsyncLog::instance().write(::phys::LogLevel::warn, __VA_ARGS__)
+#else
+#define PHYS_LOG_WARN(...) ((void)0)
+#endif
+
+#if PHYS_LOG_LEVEL <= PHYS_LOG_LEVEL_ERROR
+#define PHYS_LOG_ERROR(...) ::phys::AsyncLog::instance().write(::phys::LogLevel::error, __VA_ARGS__)
+#else
+#define PHYS_LOG_ERROR(...) ((void)0)
+#endif
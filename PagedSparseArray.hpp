@@ -0,0 +1,344 @@
+#pragma once
+#include "SnapshotStream.hpp"
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+constexpr uint32_t INVALID_HANDLE = std::numeric_limits<uint32_t>::max();
+
+// A handle is a 24 bit slot index with an 8 bit generation on top. The
+// generation is bumped every time a slot is freed, so a handle kept around
+// after its object was removed no longer matches once the slot is reused.
+// Generations never wrap: a slot freed at the top generation is retired for
+// good, so each slot holds at most 256 objects over its lifetime and indices
+// run out after roughly 4 billion removals.
+constexpr uint32_t HANDLE_INDEX_BITS       = 24;
+constexpr uint32_t HANDLE_INDEX_MASK       = (1u << HANDLE_INDEX_BITS) - 1;
+constexpr uint32_t HANDLE_GENERATION_MASK  = 0xFF;
+constexpr uint32_t MAX_HANDLE_INDEX        = HANDLE_INDEX_MASK - 1; // INVALID_HANDLE's index is never handed out
+
+constexpr uint32_t handle_index(uint32_t handle)
+{
+    return handle & HANDLE_INDEX_MASK;
+}
+
+constexpr uint32_t handle_generation(uint32_t handle)
+{
+    return handle >> HANDLE_INDEX_BITS;
+}
+
+constexpr uint32_t make_handle(uint32_t index, uint32_t generation)
+{
+    return ((generation & HANDLE_GENERATION_MASK) << HANDLE_INDEX_BITS) | index;
+}
+
+/// <summary>
+/// Handle to dense index map shared by SparseSet and SoASparseSet. Slots are
+/// grouped into fixed size pages that are only allocated once a handle in
+/// them is live, and released again once they empty out, so memory follows
+/// the number of live handles rather than the highest one ever handed out.
+/// Freed slot indices are reused oldest first, and only once more than a page
+/// worth are waiting, so churning one object spreads over many slots instead
+/// of running one slot through its generations.
+/// </summary>
+class PagedSparseArray
+{
+  private:
+    static constexpr uint32_t PAGE_BITS = 10;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS; // slots per page
+    static constexpr uint32_t MIN_FREE_INDICES = PAGE_SIZE; // freed slots held back before any is reused
+
+    struct Page
+    {
+        uint32_t dense_indices[PAGE_SIZE]; // INVALID_HANDLE for free slots
+        uint8_t  generations[PAGE_SIZE];
+        uint32_t live = 0;
+    };
+
+    std::vector<std::unique_ptr<Page>> pages{};
+    // Generation every slot of a page starts at when the page is (re)allocated.
+    // Raised past anything the page handed out when it is released, so handles
+    // from before the release stay stale. A page with a slot at the top
+    // generation is never released, as that would need a generation past it.
+    std::vector<uint8_t>               page_generations{};
+
+    uint32_t              next_index = 0;
+    std::vector<uint32_t> free_indices{}; // slot indices of removed objects, ready for reuse from free_head on
+    size_t                free_head  = 0;
+
+    Page* find_page(uint32_t index) const
+    {
+        uint32_t page = index >> PAGE_BITS;
+        return page < pages.size() ? pages[page].get() : nullptr;
+    }
+
+    Page& acquire_page(uint32_t index)
+    {
+        uint32_t page = index >> PAGE_BITS;
+        if (page >= pages.size())
+        {
+            pages.resize(page + 1);
+            page_generations.resize(page + 1, 0);
+        }
+        if (pages[page] == nullptr)
+        {
+            pages[page] = std::make_unique<Page>();
+            std::fill(std::begin(pages[page]->dense_indices), std::end(pages[page]->dense_indices), INVALID_HANDLE);
+            std::fill(std::begin(pages[page]->generations), std::end(pages[page]->generations), page_generations[page]);
+        }
+        return *pages[page];
+    }
+
+    // Every page covers handed out indices only, each page's live count is
+    // right, and every queued index is free and queued once.
+    bool is_consistent() const
+    {
+        if (next_index > MAX_HANDLE_INDEX + 1 or pages.size() != (size_t(next_index) + PAGE_SIZE - 1) / PAGE_SIZE)
+        {
+            return false;
+        }
+
+        for (size_t page_index = 0; page_index < pages.size(); page_index++)
+        {
+            const Page* page = pages[page_index].get();
+            if (page == nullptr)
+            {
+                continue;
+            }
+
+            uint32_t live = 0;
+            for (uint32_t offset = 0; offset < PAGE_SIZE; offset++)
+            {
+                if (page->dense_indices[offset] != INVALID_HANDLE)
+                {
+                    if ((page_index << PAGE_BITS) + offset >= next_index)
+                    {
+                        return false;
+                    }
+                    live++;
+                }
+            }
+            if (live != page->live)
+            {
+                return false;
+            }
+        }
+
+        std::vector<bool> queued(next_index, false);
+        for (size_t i = free_head; i < free_indices.size(); i++)
+        {
+            uint32_t index = free_indices[i];
+            if (index >= next_index or queued[index])
+            {
+                return false;
+            }
+            queued[index] = true;
+
+            const Page* page = find_page(index);
+            if (page != nullptr and page->dense_indices[index & (PAGE_SIZE - 1)] != INVALID_HANDLE)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  public:
+    /// <summary>
+    /// Hands out a handle pointing at dense_index.
+    /// </summary>
+    uint32_t allocate(uint32_t dense_index)
+    {
+        uint32_t index;
+        size_t   free_count = free_indices.size() - free_head;
+        if (free_count > MIN_FREE_INDICES or (free_count > 0 and next_index > MAX_HANDLE_INDEX))
+        {
+            index = free_indices[free_head];
+            free_head++;
+
+            // Drops the used up front once it is at least half the vector.
+            if (free_head == free_indices.size())
+            {
+                free_indices.clear();
+                free_head = 0;
+            }
+            else if (free_head >= PAGE_SIZE and free_head * 2 >= free_indices.size())
+            {
+                free_indices.erase(free_indices.begin(), free_indices.begin() + free_head);
+                free_head = 0;
+            }
+        }
+        else
+        {
+            if (next_index > MAX_HANDLE_INDEX)
+            {
+                throw std::runtime_error("PagedSparseArray::Allocate() failed. Out of handle indices.");
+            }
+            index = next_index;
+            next_index++;
+        }
+
+        Page&    page   = acquire_page(index);
+        uint32_t offset = index & (PAGE_SIZE - 1);
+        page.dense_indices[offset] = dense_index;
+        page.live++;
+        return make_handle(index, page.generations[offset]);
+    }
+
+    /// <summary>
+    /// Frees a handle's slot. The handle must be live, see contains(). A slot
+    /// freed at the top generation is retired instead of queued for reuse.
+    /// </summary>
+    void release(uint32_t handle)
+    {
+        uint32_t index  = handle_index(handle);
+        uint32_t offset = index & (PAGE_SIZE - 1);
+        Page&    page   = *find_page(index);
+
+        page.dense_indices[offset] = INVALID_HANDLE;
+        page.live--;
+        if (page.generations[offset] < HANDLE_GENERATION_MASK)
+        {
+            page.generations[offset]++;
+            free_indices.push_back(index);
+        }
+
+        if (page.live == 0)
+        {
+            uint8_t highest = 0;
+            for (uint8_t generation : page.generations)
+            {
+                highest = std::max(highest, generation);
+            }
+            if (highest < HANDLE_GENERATION_MASK)
+            {
+                uint32_t page_index = index >> PAGE_BITS;
+                page_generations[page_index] = highest + 1;
+                pages[page_index].reset();
+            }
+        }
+    }
+
+    /// <summary>
+    /// Dense index of a live handle, INVALID_HANDLE if it is stale or was never handed out.
+    /// </summary>
+    uint32_t get_dense_index(uint32_t handle) const
+    {
+        uint32_t index = handle_index(handle);
+        Page*    page  = find_page(index);
+        if (page == nullptr)
+        {
+            return INVALID_HANDLE;
+        }
+
+        uint32_t offset = index & (PAGE_SIZE - 1);
+        if (page->generations[offset] != handle_generation(handle))
+        {
+            return INVALID_HANDLE;
+        }
+        return page->dense_indices[offset];
+    }
+
+    /// <summary>
+    /// Repoints a live handle, used when its object moves inside the dense arrays.
+    /// </summary>
+    void set_dense_index(uint32_t handle, uint32_t dense_index)
+    {
+        uint32_t index = handle_index(handle);
+        find_page(index)->dense_indices[index & (PAGE_SIZE - 1)] = dense_index;
+    }
+
+    bool contains(uint32_t handle) const
+    {
+        return get_dense_index(handle) != INVALID_HANDLE;
+    }
+
+    /// <summary>
+    /// Appends every page, generation and free index to the writer.
+    /// </summary>
+    void save(SnapshotWriter& writer) const
+    {
+        // Only the part still queued, laid out as write_vector() would.
+        writer.write_value(next_index);
+        writer.write_value<uint64_t>(free_indices.size() - free_head);
+        writer.write(free_indices.data() + free_head, (free_indices.size() - free_head) * sizeof(uint32_t));
+        writer.write_vector(page_generations);
+        for (const std::unique_ptr<Page>& page : pages)
+        {
+            writer.write_value<uint8_t>(page != nullptr);
+            if (page != nullptr)
+            {
+                writer.write_value(*page);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Replaces everything with what save() wrote. Pages allocated on both
+    /// sides are copied over in place rather than allocated again. Throws if
+    /// the slots don't fit together, after which the contents are garbage
+    /// until the next load() that succeeds.
+    /// </summary>
+    void load(SnapshotReader& reader)
+    {
+        next_index = reader.read_value<uint32_t>();
+        reader.read_vector(free_indices);
+        free_head = 0;
+        reader.read_vector(page_generations);
+
+        pages.resize(page_generations.size());
+        for (std::unique_ptr<Page>& page : pages)
+        {
+            if (reader.read_value<uint8_t>() != 0)
+            {
+                if (page == nullptr)
+                {
+                    page = std::make_unique<Page>();
+                }
+                reader.read(page.get(), sizeof(Page));
+            }
+            else
+            {
+                page.reset();
+            }
+        }
+
+        if (not is_consistent())
+        {
+            throw std::runtime_error("PagedSparseArray::Load() failed. The snapshot's handle slots don't fit together.");
+        }
+    }
+
+    /// <summary>
+    /// Whether each of the given handles points at its own position in the
+    /// list, and no other slot is live. A set's handles and its slots have to
+    /// agree like this.
+    /// </summary>
+    bool matches(std::span<const uint32_t> associated_handles) const
+    {
+        size_t live = 0;
+        for (const std::unique_ptr<Page>& page : pages)
+        {
+            live += (page != nullptr) ? page->live : 0;
+        }
+        if (live != associated_handles.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < associated_handles.size(); i++)
+        {
+            if (get_dense_index(associated_handles[i]) != i)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
\ No newline at end of file
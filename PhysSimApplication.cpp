@@ -11,19 +11,35 @@ void PhysSimApplication::process_input()
     {
         glfwSetWindowShouldClose(window, true);
     }
+
+    bool debug_key_pressed = glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS;
+    if (debug_key_pressed and not debug_key_down)
+    {
+        debug_objects_requested = true;
+    }
+    debug_key_down = debug_key_pressed;
 }
 
 void PhysSimApplication::init_glfw()
 {
     // Instantiate the GLFW window.
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    // Create GLFW window object.
-    window = glfwCreateWindow(
-        WIDTH, HEIGHT, "OpenGL Application", NULL, NULL);
+    // Create GLFW window object. 4.4 lets gfx::TransformStream persistently map
+    // its buffer, drivers without it get 3.3 and the glBufferSubData fallback.
+    const int context_versions[][2] = { { 4, 4 }, { 3, 3 } };
+    window = NULL;
+    for (const int* version : context_versions)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        window = glfwCreateWindow(
+            WIDTH, HEIGHT, "OpenGL Application", NULL, NULL);
+        if (window != NULL) {
+            break;
+        }
+    }
     if (window == NULL) {
         cleanup();
         throw std::runtime_error("Failed to create GLFW window");
@@ -80,7 +96,7 @@ void PhysSimApplication::init_objects()
     const char* vertex_shader_source = "shaders/shader.vert";
     const char* fragment_shader_source = "shaders/shader.frag";
 
-    uint32_t shader_program = shader_system->create_shader_program(vertex_shader_source, fragment_shader_source);
+    uint32_t shader_program = shader_system->create_shader_program(vertex_shader_source, fragment_shader_source).id;
 
     uint32_t vbo;
     glGenBuffers(1, &vbo);
@@ -112,48 +128,13 @@ void PhysSimApplication::init_objects()
     phys::DynamicID   ap = physics_system->add_dynamic(glm::vec3(-3.0f, 0.0f, -6.5f), glm::vec3(0.0f), glm::vec3(200.0f, 5000.0f, 0.0f), 1.0f);
     gfx::RenderableID ar = rendering_system->new_renderable({mesh_id, ap});
 
-    std::vector<glm::vec3> block_positions
-    {
-        glm::vec3(-6, -3, -6.5f),
-        glm::vec3(-5, -3, -6.5f),
-        glm::vec3(-4, -3, -6.5f),
-        glm::vec3(-3, -3, -6.5f),
-        glm::vec3(-2, -3, -6.5f),
-        glm::vec3(-1, -3, -6.5f),
-        glm::vec3(0, -3, -6.5f),
-        glm::vec3(1, -3, -6.5f),
-        glm::vec3(2, -3, -6.5f),
-        glm::vec3(3, -3, -6.5f),
-        glm::vec3(5, -3, -6.5f),
-        glm::vec3(4, -3, -6.5f),
-        glm::vec3(6, -3, -6.5f),
-
-        glm::vec3(6, -2, -6.5f),
-        glm::vec3(6, -1, -6.5f),
-        glm::vec3(6, -0, -6.5f),
-        glm::vec3(6, 1, -6.5f),
-        glm::vec3(6, 2, -6.5f),
-
-        glm::vec3(-6, 3, -6.5f),
-        glm::vec3(-5, 3, -6.5f),
-        glm::vec3(-4, 3, -6.5f),
-        glm::vec3(-3, 3, -6.5f),
-        glm::vec3(-2, 3, -6.5f),
-        glm::vec3(-1, 3, -6.5f),
-        glm::vec3(0, 3, -6.5f),
-        glm::vec3(1, 3, -6.5f),
-        glm::vec3(2, 3, -6.5f),
-        glm::vec3(3, 3, -6.5f),
-        glm::vec3(5, 3, -6.5f),
-        glm::vec3(4, 3, -6.5f),
-        glm::vec3(6, 3, -6.5f),
-    
-    };
-    for (glm::vec3& block_pos : block_positions)
-    {
-        phys::StaticID id = physics_system->add_static(block_pos);
-        rendering_system->new_renderable({ mesh_id, id });
-    }
+    // The static world is made offline by level-converter from levels/demo.txt.
+    phys::LevelFile             level("levels/demo.level");
+    std::vector<phys::StaticID> block_ids;
+    phys::load_level(level, *physics_system, block_ids);
+
+    std::vector<gfx::RenderableID> block_renderables;
+    rendering_system->new_renderables(mesh_id, block_ids, block_renderables);
 }
 
 void PhysSimApplication::init()
@@ -164,9 +145,13 @@ void PhysSimApplication::init()
 
 void PhysSimApplication::main_loop()
 {
+    if (threaded_physics)
+    {
+        threaded_main_loop();
+        return;
+    }
+
     auto last_update_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    const double tick_rate = 60.0; // in updates/sec
-    const double tick_duration = 1.0 / tick_rate; // 1 second / ticks per second = length of a tick
     double accumulator = 0;
 
     // Application loop
@@ -182,10 +167,12 @@ void PhysSimApplication::main_loop()
         while (accumulator > tick_duration)
         {
             physics_system->step(tick_duration);
+            accumulator -= tick_duration;
+        }
 
+        if (debug_objects_requested.exchange(false))
+        {
             physics_system->debug_objects();
-
-            accumulator -= tick_duration;
         }
 
         // Rendering here ..
@@ -199,6 +186,105 @@ void PhysSimApplication::main_loop()
     }
 }
 
+void PhysSimApplication::threaded_main_loop()
+{
+    // Publish the starting state so the first frames have something to draw.
+    phys::PhysicsSnapshot& initial = snapshots.get_back();
+    physics_system->write_snapshot(initial);
+    initial.time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    snapshots.publish();
+
+    physics_running = true;
+    physics_thread = std::thread(&PhysSimApplication::physics_loop, this);
+
+    // Application loop
+    try
+    {
+        while (!glfwWindowShouldClose(window) and physics_running)
+        {
+            process_input();
+
+            const phys::PhysicsSnapshot& snapshot = snapshots.acquire();
+
+            // Time since the snapshot's tick completed is the render thread's view
+            // of the physics thread's leftover accumulator.
+            double now_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+            float  alpha    = (float)std::clamp((now_time - snapshot.time) / tick_duration, 0.0, 1.0);
+
+            // Rendering here ..
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            rendering_system->render(&snapshot, alpha);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+    }
+    catch (...)
+    {
+        physics_running = false;
+        physics_thread.join();
+        throw;
+    }
+
+    physics_running = false;
+    physics_thread.join();
+    if (physics_error)
+    {
+        std::rethrow_exception(physics_error);
+    }
+}
+
+void PhysSimApplication::physics_loop()
+{
+    auto last_update_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    double   accumulator = 0;
+    uint64_t tick        = 0;
+
+    try
+    {
+        while (physics_running)
+        {
+            double now_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+            double delta_time = now_time - last_update_time;
+            last_update_time += delta_time;
+            accumulator += delta_time;
+
+            bool stepped = false;
+            while (accumulator > tick_duration)
+            {
+                physics_system->step(tick_duration);
+                accumulator -= tick_duration;
+                tick++;
+                stepped = true;
+            }
+
+            if (stepped)
+            {
+                phys::PhysicsSnapshot& snapshot = snapshots.get_back();
+                physics_system->write_snapshot(snapshot);
+                snapshot.tick = tick;
+                snapshot.time = now_time - accumulator;
+                snapshots.publish();
+            }
+
+            if (debug_objects_requested.exchange(false))
+            {
+                physics_system->debug_objects();
+            }
+
+            std::this_thread::sleep_for(std::chrono::duration<double>(tick_duration - accumulator));
+        }
+    }
+    catch (...)
+    {
+        // Handed back to the main thread, which stops rendering and rethrows it.
+        physics_error   = std::current_exception();
+        physics_running = false;
+    }
+}
+
 void PhysSimApplication::cleanup()
 {
     glfwDestroyWindow(window);
@@ -220,6 +306,21 @@ PhysSimApplication::PhysSimApplication
 {
 }
 
+void PhysSimApplication::set_threaded_physics(bool threaded)
+{
+    threaded_physics = threaded;
+}
+
+void PhysSimApplication::set_tick_rate(double rate)
+{
+    if (not (rate > 0.0))
+    {
+        throw std::runtime_error("Tick rate must be positive");
+    }
+    tick_rate     = rate;
+    tick_duration = 1.0 / rate;
+}
+
 void PhysSimApplication::run()
 {
     init();
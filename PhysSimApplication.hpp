@@ -1,10 +1,15 @@
 #pragma once
+#include "LevelFile.hpp"
 #include "MeshRegistry.hpp"
 #include "PhysicsSystem.hpp"
 #include "RenderingSystem.hpp"
 #include "ShaderSystem.hpp"
 
+#include <atomic>
+#include <algorithm>
 #include <chrono>
+#include <thread>
+#include <exception>
 #include <format>
 #include <iostream>
 #include <type_traits>
@@ -40,6 +45,24 @@ class PhysSimApplication
     std::shared_ptr<gfx::MeshRegistry>    mesh_registry;
     std::shared_ptr<phys::PhysicsSystem>  physics_system;
     std::shared_ptr<gfx::RenderingSystem> rendering_system;
+
+    double tick_rate     = 60.0;             // in updates/sec
+    double tick_duration = 1.0 / tick_rate;  // 1 second / ticks per second = length of a tick
+
+    // Threaded mode: physics ticks on physics_thread and hands positions to the
+    // render loop through snapshots. Statics are still read live, which is safe
+    // because step() never writes them; adding or removing objects while the
+    // physics thread runs is not.
+    bool                       threaded_physics = false;
+    std::thread                physics_thread;
+    std::atomic<bool>          physics_running = false;
+    std::exception_ptr         physics_error   = nullptr;
+    phys::SnapshotTripleBuffer snapshots;
+
+    // Set by pressing F1, cleared by whichever loop steps physics once it has
+    // logged every dynamic object. Logging them every tick floods the log.
+    std::atomic<bool> debug_objects_requested = false;
+    bool              debug_key_down          = false;
     
     /// <summary>
     /// Handle keyboard and mouse input within the glfw window--call each frame.
@@ -62,6 +85,19 @@ class PhysSimApplication
     /// </summary>
     void main_loop();
 
+    /// <summary>
+    /// Main loop for threaded mode. Renders the newest snapshot every frame,
+    /// interpolated by how far into the next tick the frame is, and never
+    /// waits on the physics thread.
+    /// </summary>
+    void threaded_main_loop();
+
+    /// <summary>
+    /// Fixed tick loop run on physics_thread. Publishes a snapshot after every
+    /// batch of ticks, then sleeps until the next tick is due.
+    /// </summary>
+    void physics_loop();
+
     /// <summary>
     /// Clean up application resources after exiting
     /// </summary>
@@ -76,6 +112,17 @@ class PhysSimApplication
         std::shared_ptr<gfx::RenderingSystem> rendering_system
     );
 
+    /// <summary>
+    /// Run physics on its own thread instead of between frames. Call before run().
+    /// </summary>
+    void set_threaded_physics(bool threaded);
+
+    /// <summary>
+    /// Physics updates per second. Fast objects are swept against the statics,
+    /// so lower rates don't let them pass through walls. Call before run().
+    /// </summary>
+    void set_tick_rate(double rate);
+
     /// <summary>
     /// Start & run the application until termination
     /// </summary>
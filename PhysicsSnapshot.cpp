@@ -0,0 +1,23 @@
+#include "PhysicsSnapshot.hpp"
+
+phys::PhysicsSnapshot& phys::SnapshotTripleBuffer::get_back()
+{
+    return slots[back];
+}
+
+void phys::SnapshotTripleBuffer::publish()
+{
+    // Release so the reader sees the slot's contents along with the index.
+    uint32_t previous = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel);
+    back = previous & INDEX_MASK;
+}
+
+const phys::PhysicsSnapshot& phys::SnapshotTripleBuffer::acquire()
+{
+    if (middle.load(std::memory_order_relaxed) & FRESH_BIT)
+    {
+        uint32_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX_MASK;
+    }
+    return slots[front];
+}
\ No newline at end of file
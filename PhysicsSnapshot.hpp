@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+/// <summary>
+/// Immutable copy of where every dynamic object was at the end of one tick
+/// and the tick before it, indexed by handle_index(DynamicID) so a reader needs
+/// no access to the PhysicsSystem. Slots of removed ids hold stale data.
+/// </summary>
+struct PhysicsSnapshot
+{
+    uint64_t               tick = 0;
+    double                 time = 0.0;           // wall clock seconds at which positions were current
+    std::vector<glm::vec3> previous_positions{}; // at the end of the tick before
+    std::vector<glm::vec3> positions{};
+};
+
+/// <summary>
+/// Single producer, single consumer triple buffer. The writer fills the back
+/// slot and publishes it; the reader takes the newest published slot. Neither
+/// side ever waits on the other, and a slot is never touched by both at once.
+/// </summary>
+class SnapshotTripleBuffer
+{
+  private:
+    static constexpr uint32_t FRESH_BIT  = 0b100; // middle holds a snapshot the reader hasn't taken yet
+    static constexpr uint32_t INDEX_MASK = 0b011;
+
+    std::array<PhysicsSnapshot, 3> slots{};
+    std::atomic<uint32_t>          middle = 1;
+    uint32_t                       back   = 0; // only touched by the writer
+    uint32_t                       front  = 2; // only touched by the reader
+
+  public:
+    /// <summary>
+    /// Writer side. The slot to fill next, its previous contents are reusable.
+    /// </summary>
+    PhysicsSnapshot& get_back();
+
+    /// <summary>
+    /// Writer side. Hands the back slot to the reader, replacing any snapshot
+    /// it hasn't picked up yet.
+    /// </summary>
+    void publish();
+
+    /// <summary>
+    /// Reader side. Takes the newest published snapshot if there is one,
+    /// otherwise keeps the one it already had. Valid until the next acquire().
+    /// </summary>
+    const PhysicsSnapshot& acquire();
+};
+
+}
\ No newline at end of file
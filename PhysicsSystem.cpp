@@ -1,5 +1,35 @@
 #include "PhysicsSystem.hpp"
 
+phys::PhysicsSystem::PhysicsSystem(std::shared_ptr<JobSystem> job_system)
+    :
+    job_system(std::move(job_system))
+{
+    if (not this->job_system)
+    {
+        this->job_system = std::make_shared<JobSystem>();
+    }
+}
+
+void phys::PhysicsSystem::set_thread_count(size_t thread_count)
+{
+    job_system = std::make_shared<JobSystem>(thread_count);
+}
+
+void phys::PhysicsSystem::set_deterministic(bool enabled)
+{
+    deterministic = enabled;
+}
+
+size_t phys::PhysicsSystem::chunk_size_for(size_t count) const
+{
+    if (deterministic)
+    {
+        return DETERMINISTIC_CHUNK_SIZE;
+    }
+    // A few chunks per thread leaves room for stealing to even out the load.
+    return std::max<size_t>(64, count / (job_system->get_thread_count() * 4));
+}
+
 phys::StaticObject& phys::PhysicsSystem::get_static(StaticID id)
 {
     if (static_objects.has(id))
@@ -15,11 +45,11 @@ phys::StaticObject& phys::PhysicsSystem::get_static(StaticID id)
     }
 }
 
-phys::DynamicObject& phys::PhysicsSystem::get_dynamic(DynamicID id)
+phys::DynamicObjectRef phys::PhysicsSystem::get_dynamic(DynamicID id)
 {
     if (dynamic_objects.has(id))
     {
-        return dynamic_objects.get(id);
+        return get_dynamic_at(dynamic_objects.get_dense_index(id));
     }
     else
     {
@@ -30,17 +60,54 @@ phys::DynamicObject& phys::PhysicsSystem::get_dynamic(DynamicID id)
     }
 }
 
-phys::StaticID phys::PhysicsSystem::add_static(const glm::vec3& pos)
+phys::StaticID phys::PhysicsSystem::add_static(const glm::vec3& pos, ShapeType shape, const glm::vec3& half_extents)
 {
-    StaticID id = StaticID(static_objects.add({pos}));
+    if (not is_valid_shape(shape, half_extents))
+    {
+        throw std::runtime_error("phys::PhysicsSystem::add_static() failed. Half extents don't describe a valid shape of the given type.");
+    }
+
+    StaticObject object = { pos, half_extents, shape };
+    if (static_broadphase == StaticBroadphase::voxel_grid)
+    {
+        validate_voxel_statics(static_voxels, std::span<const StaticObject>(&object, 1), "add_static");
+    }
+
+    StaticID id = StaticID(static_objects.add(object));
+    glm::vec3 extent = half_extents;
+    switch (static_broadphase)
+    {
+        case StaticBroadphase::spatial_hash:
+            static_hash.insert(id, pos - extent, pos + extent);
+            break;
+        case StaticBroadphase::bvh:
+            static_bvh.insert(id, pos - extent, pos + extent);
+            break;
+        case StaticBroadphase::voxel_grid:
+            static_voxels.insert(id, pos);
+            break;
+    }
     return id;
 }
 
-phys::DynamicID phys::PhysicsSystem::add_dynamic(const glm::vec3& pos, const glm::vec3& vel, const glm::vec3& f, float m)
+phys::DynamicID phys::PhysicsSystem::add_dynamic(const glm::vec3& pos, const glm::vec3& vel, const glm::vec3& f, float m,
+                                                 ShapeType shape, const glm::vec3& half_extents)
 {
+    if (not is_valid_shape(shape, half_extents))
+    {
+        throw std::runtime_error("phys::PhysicsSystem::add_dynamic() failed. Half extents don't describe a valid shape of the given type.");
+    }
+
     if (m > 0.0f)
     {
-        DynamicID id = DynamicID(dynamic_objects.add({ pos, vel, f, m }));
+        DynamicID id = DynamicID(dynamic_objects.add(pos, vel, f, m, 0, NO_ISLAND, half_extents, shape));
+        previous_positions.push_back(pos);
+
+        // New bodies start awake.
+        swap_dynamics(dynamic_objects.size() - 1, awake_count);
+        awake_count++;
+
+        dynamic_sap.insert(id, pos - half_extents, pos + half_extents);
         return id;
     }
     else
@@ -53,6 +120,35 @@ void phys::PhysicsSystem::remove_static(StaticID id)
 {
     if (static_objects.has(id))
     {
+        // Anything asleep on top of it has to fall now.
+        glm::vec3 static_position = static_objects.get(id).position;
+        glm::vec3 extent          = static_objects.get(id).half_extents;
+        auto&     positions       = dynamic_objects.get_field<POSITION>();
+        auto&     half_extents    = dynamic_objects.get_field<HALF_EXTENTS>();
+        auto&     islands         = dynamic_objects.get_field<ISLAND>();
+        for (size_t i = awake_count; i < dynamic_objects.size(); i++)
+        {
+            glm::vec3 distance = glm::abs(positions[i] - static_position);
+            glm::vec3 reach    = half_extents[i] + extent;
+            if (distance.x <= reach.x and distance.y <= reach.y and distance.z <= reach.z)
+            {
+                wake_island(islands[i]);
+                i = awake_count - 1; // waking reshuffled the sleeping range, start over
+            }
+        }
+
+        switch (static_broadphase)
+        {
+            case StaticBroadphase::spatial_hash:
+                static_hash.remove(id, static_position - extent, static_position + extent);
+                break;
+            case StaticBroadphase::bvh:
+                static_bvh.remove(id);
+                break;
+            case StaticBroadphase::voxel_grid:
+                static_voxels.remove(static_position);
+                break;
+        }
         static_objects.remove(id);
     }
     else
@@ -68,7 +164,8 @@ void phys::PhysicsSystem::remove_dynamic(DynamicID id)
 {
     if (dynamic_objects.has(id))
     {
-        dynamic_objects.remove(id);
+        dynamic_sap.remove(id);
+        remove_dynamic_storage(id);
     }
     else
     {
@@ -78,252 +175,1070 @@ void phys::PhysicsSystem::remove_dynamic(DynamicID id)
         );
     }
 }
-const glm::vec3 phys::PhysicsSystem::get_overlap(const glm::vec3& pos1, const glm::vec3 pos2, float half_width) const
+
+void phys::PhysicsSystem::add_statics(std::span<const StaticObject> objects, std::vector<StaticID>& ids)
+{
+    for (const StaticObject& object : objects)
+    {
+        if (not is_valid_shape(object.shape, object.half_extents))
+        {
+            throw std::runtime_error("phys::PhysicsSystem::add_statics() failed. Half extents don't describe a valid shape of the given type.");
+        }
+    }
+
+    if (static_broadphase == StaticBroadphase::voxel_grid)
+    {
+        validate_voxel_statics(static_voxels, objects, "add_statics");
+    }
+
+    batch_handles.clear();
+    static_objects.add_batch(objects, batch_handles);
+
+    ids.reserve(ids.size() + batch_handles.size());
+    for (uint32_t handle : batch_handles)
+    {
+        ids.push_back(StaticID(handle));
+    }
+
+    switch (static_broadphase)
+    {
+        case StaticBroadphase::spatial_hash:
+            for (size_t i = 0; i < objects.size(); i++)
+            {
+                static_hash.insert(batch_handles[i], objects[i].position - objects[i].half_extents, objects[i].position + objects[i].half_extents);
+            }
+            break;
+        case StaticBroadphase::bvh:
+            rebuild_static_broadphase();
+            break;
+        case StaticBroadphase::voxel_grid:
+            for (size_t i = 0; i < objects.size(); i++)
+            {
+                static_voxels.insert(batch_handles[i], objects[i].position);
+            }
+            break;
+    }
+}
+
+void phys::PhysicsSystem::add_statics(std::span<const StaticObject> objects, std::span<const BVHNode> bvh_nodes, int32_t bvh_root,
+                                      std::vector<StaticID>& ids)
+{
+    // The tree only covers the given objects, statics already added would be missing from it.
+    if (static_broadphase != StaticBroadphase::bvh or not static_objects.get_dense().empty())
+    {
+        add_statics(objects, ids);
+        return;
+    }
+
+    for (const StaticObject& object : objects)
+    {
+        if (not is_valid_shape(object.shape, object.half_extents))
+        {
+            throw std::runtime_error("phys::PhysicsSystem::add_statics() failed. Half extents don't describe a valid shape of the given type.");
+        }
+    }
+
+    batch_handles.clear();
+    static_objects.add_batch(objects, batch_handles);
+    try
+    {
+        static_bvh.load(bvh_nodes, bvh_root, batch_handles, [objects](uint32_t index, glm::vec3& min, glm::vec3& max)
+        {
+            min = objects[index].position - objects[index].half_extents;
+            max = objects[index].position + objects[index].half_extents;
+        });
+    }
+    catch (const std::runtime_error&)
+    {
+        static_objects.remove_batch(batch_handles);
+        throw;
+    }
+
+    ids.reserve(ids.size() + batch_handles.size());
+    for (uint32_t handle : batch_handles)
+    {
+        ids.push_back(StaticID(handle));
+    }
+}
+
+void phys::PhysicsSystem::add_dynamics(std::span<const DynamicObject> objects, std::vector<DynamicID>& ids)
+{
+    for (const DynamicObject& object : objects)
+    {
+        if (not (object.mass > 0.0f))
+        {
+            throw std::runtime_error("phys::PhysicsSystem::add_dynamics() failed. Mass cannot be a value <= 0.0f");
+        }
+        if (not is_valid_shape(object.shape, object.half_extents))
+        {
+            throw std::runtime_error("phys::PhysicsSystem::add_dynamics() failed. Half extents don't describe a valid shape of the given type.");
+        }
+    }
+
+    dynamic_objects.reserve(dynamic_objects.size() + objects.size());
+    ids.reserve(ids.size() + objects.size());
+    batch_handles.clear();
+    previous_positions.reserve(previous_positions.size() + objects.size());
+    for (const DynamicObject& object : objects)
+    {
+        uint32_t handle = dynamic_objects.add(object.position, object.velocity, object.force, object.mass, 0, NO_ISLAND,
+                                              object.half_extents, object.shape);
+        previous_positions.push_back(object.position);
+        swap_dynamics(dynamic_objects.size() - 1, awake_count);
+        awake_count++;
+
+        batch_handles.push_back(handle);
+        ids.push_back(DynamicID(handle));
+    }
+
+    dynamic_sap.insert_batch(batch_handles, [this](uint32_t handle, glm::vec3& min, glm::vec3& max)
+    {
+        auto object = dynamic_objects.get(handle);
+        min = std::get<POSITION>(object) - std::get<HALF_EXTENTS>(object);
+        max = std::get<POSITION>(object) + std::get<HALF_EXTENTS>(object);
+    });
+}
+
+void phys::PhysicsSystem::remove_dynamics(std::span<const DynamicID> ids)
+{
+    batch_handles.clear();
+    for (DynamicID id : ids)
+    {
+        if (not dynamic_objects.has(id))
+        {
+            throw std::runtime_error
+            (
+                "phys::PhysicsSystem::remove_dynamics() failed. Given DynamicID does not refer to an existing dynamic object."
+            );
+        }
+        batch_handles.push_back(id);
+    }
+
+    std::vector<uint32_t> sorted(batch_handles.begin(), batch_handles.end());
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+    {
+        throw std::runtime_error("phys::PhysicsSystem::remove_dynamics() failed. The same DynamicID is given more than once.");
+    }
+
+    dynamic_sap.remove_batch(batch_handles);
+    for (uint32_t handle : batch_handles)
+    {
+        remove_dynamic_storage(DynamicID(handle));
+    }
+}
+
+void phys::PhysicsSystem::remove_dynamic_storage(DynamicID id)
+{
+    size_t index = dynamic_objects.get_dense_index(id);
+
+    // Whatever was resting on a sleeping body has to fall now, as in remove_static().
+    if (index >= awake_count)
+    {
+        wake_island(dynamic_objects.get_field<ISLAND>()[index]);
+        index = dynamic_objects.get_dense_index(id);
+    }
+
+    // Close the gap in the awake range first, so the swap and pop below only
+    // ever moves a sleeping body.
+    if (index < awake_count)
+    {
+        swap_dynamics(index, awake_count - 1);
+        awake_count--;
+        index = awake_count;
+    }
+
+    // Mirrors the swap and pop dynamic_objects.remove() does.
+    previous_positions[index] = previous_positions.back();
+    previous_positions.pop_back();
+    dynamic_objects.remove(id);
+}
+
+void phys::PhysicsSystem::apply_force(DynamicID id, const glm::vec3& force)
+{
+    get_dynamic(id).force += force;
+    wake(id);
+}
+
+void phys::PhysicsSystem::wake(DynamicID id)
+{
+    if (is_sleeping(id))
+    {
+        wake_island(std::get<ISLAND>(dynamic_objects.get(id)));
+    }
+}
+
+bool phys::PhysicsSystem::is_sleeping(DynamicID id)
+{
+    if (dynamic_objects.has(id))
+    {
+        return dynamic_objects.get_dense_index(id) >= awake_count;
+    }
+    else
+    {
+        throw std::runtime_error
+        (
+            "phys::PhysicsSystem::is_sleeping() failed. Given DynamicID does not refer to an existing dynamic object."
+        );
+    }
+}
+
+size_t phys::PhysicsSystem::get_awake_count() const
+{
+    return awake_count;
+}
+
+void phys::PhysicsSystem::set_sleeping(bool enabled)
+{
+    sleeping_enabled = enabled;
+    if (not enabled)
+    {
+        auto& still_ticks = dynamic_objects.get_field<STILL_TICKS>();
+        auto& islands     = dynamic_objects.get_field<ISLAND>();
+        std::fill(still_ticks.begin(), still_ticks.end(), 0);
+        std::fill(islands.begin(), islands.end(), NO_ISLAND);
+        awake_count = dynamic_objects.size();
+    }
+}
+
+void phys::PhysicsSystem::set_solver_iterations(uint32_t iterations)
+{
+    contact_solver.set_iterations(iterations);
+}
+
+void phys::PhysicsSystem::set_restitution(float restitution)
+{
+    contact_solver.set_restitution(restitution);
+}
+
+phys::DynamicObjectRef phys::PhysicsSystem::get_dynamic_at(size_t index)
+{
+    return
+    {
+        dynamic_objects.get_field<POSITION>()[index],
+        dynamic_objects.get_field<VELOCITY>()[index],
+        dynamic_objects.get_field<FORCE>()[index],
+        dynamic_objects.get_field<MASS>()[index],
+        dynamic_objects.get_field<HALF_EXTENTS>()[index],
+        dynamic_objects.get_field<SHAPE>()[index]
+    };
+}
+
+void phys::PhysicsSystem::swap_dynamics(size_t a, size_t b)
+{
+    dynamic_objects.swap_dense(a, b);
+    std::swap(previous_positions[a], previous_positions[b]);
+}
+
+void phys::PhysicsSystem::wake_island(uint32_t island)
+{
+    // Waking is rare next to stepping, so a scan of the sleeping range beats
+    // keeping a member list per island up to date.
+    auto& still_ticks = dynamic_objects.get_field<STILL_TICKS>();
+    auto& islands     = dynamic_objects.get_field<ISLAND>();
+    for (size_t i = awake_count; i < dynamic_objects.size(); i++)
+    {
+        if (islands[i] == island)
+        {
+            still_ticks[i] = 0;
+            islands[i]     = NO_ISLAND;
+            swap_dynamics(i, awake_count);
+            awake_count++;
+        }
+    }
+}
+
+void phys::PhysicsSystem::update_sleep(float delta_time)
+{
+    if (not sleeping_enabled)
+    {
+        return;
+    }
+
+    AlignedVector<glm::vec3>& positions   = dynamic_objects.get_field<POSITION>();
+    AlignedVector<glm::vec3>& velocities  = dynamic_objects.get_field<VELOCITY>();
+    AlignedVector<uint32_t>&  still_ticks = dynamic_objects.get_field<STILL_TICKS>();
+    AlignedVector<uint32_t>&  islands     = dynamic_objects.get_field<ISLAND>();
+
+    float max_distance = SLEEP_SPEED * delta_time;
+    for (size_t i = 0; i < awake_count; i++)
+    {
+        glm::vec3 moved = positions[i] - previous_positions[i];
+        bool      still = glm::dot(moved, moved) < max_distance * max_distance;
+        still_ticks[i]  = still ? still_ticks[i] + 1 : 0;
+    }
+
+    // Union-find over this step's contacts, so bodies resting on each other
+    // only sleep, and later wake, together.
+    island_parents.resize(awake_count);
+    for (size_t i = 0; i < awake_count; i++)
+    {
+        island_parents[i] = i;
+    }
+    auto find = [this](uint32_t i)
+    {
+        while (island_parents[i] != i)
+        {
+            island_parents[i] = island_parents[island_parents[i]];
+            i = island_parents[i];
+        }
+        return i;
+    };
+    for (auto& [handle_a, handle_b] : contact_links)
+    {
+        uint32_t a = dynamic_objects.get_dense_index(handle_a);
+        uint32_t b = dynamic_objects.get_dense_index(handle_b);
+        if (a < awake_count and b < awake_count)
+        {
+            island_parents[find(a)] = find(b);
+        }
+    }
+
+    island_roots_still.assign(awake_count, 1);
+    for (size_t i = 0; i < awake_count; i++)
+    {
+        if (still_ticks[i] < SLEEP_TICKS)
+        {
+            island_roots_still[find(i)] = 0;
+        }
+    }
+
+    // Decide everything before moving anything, the union-find is indexed by
+    // the current dense order. Each island that sleeps gets a fresh id.
+    sleep_islands.assign(awake_count, NO_ISLAND);
+    for (size_t i = 0; i < awake_count; i++)
+    {
+        uint32_t root = find(i);
+        if (island_roots_still[root])
+        {
+            if (sleep_islands[root] == NO_ISLAND)
+            {
+                sleep_islands[root] = next_island++;
+            }
+            sleep_islands[i] = sleep_islands[root];
+        }
+    }
+
+    // Walk down from the end of the awake range, so whatever gets swapped into
+    // a sleeper's slot has already been looked at and is staying awake.
+    for (size_t i = awake_count; i-- > 0;)
+    {
+        if (sleep_islands[i] != NO_ISLAND)
+        {
+            islands[i]            = sleep_islands[i];
+            velocities[i]         = glm::vec3(0.0f);
+            previous_positions[i] = positions[i];
+
+            size_t last = awake_count - 1;
+            swap_dynamics(i, last);
+            std::swap(sleep_islands[i], sleep_islands[last]);
+            awake_count--;
+        }
+    }
+}
+
+void phys::PhysicsSystem::validate_voxel_statics(const VoxelGrid& grid, std::span<const StaticObject> objects, const char* caller) const
+{
+    // Checked up front so a bad static never gets halfway in, leaving the
+    // static set and the grid out of step.
+    bool                   valid = true;
+    std::vector<glm::vec3> cells;
+    cells.reserve(objects.size());
+    for (const StaticObject& object : objects)
+    {
+        bool unit_box = object.shape == ShapeType::aabb and object.half_extents == glm::vec3(OBJECT_HALF_WIDTH);
+        if (not unit_box or not grid.can_insert(object.position))
+        {
+            valid = false;
+            break;
+        }
+        cells.push_back(object.position);
+    }
+
+    if (valid)
+    {
+        std::sort(cells.begin(), cells.end(), [](const glm::vec3& a, const glm::vec3& b)
+        {
+            return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+        });
+        valid = std::adjacent_find(cells.begin(), cells.end()) == cells.end();
+    }
+
+    if (not valid)
+    {
+        throw std::runtime_error
+        (
+            std::string("phys::PhysicsSystem::") + caller + "() failed. "
+            "The voxel grid broadphase needs every static to be a unit box on a cell centre, one per cell."
+        );
+    }
+}
+
+void phys::PhysicsSystem::set_static_broadphase(StaticBroadphase type, const glm::vec3& voxel_offset)
+{
+    if (type == StaticBroadphase::voxel_grid)
+    {
+        // Checked against an empty grid, the statics already in the current
+        // one would all count as taken.
+        validate_voxel_statics(VoxelGrid(voxel_offset), static_objects.get_dense(), "set_static_broadphase");
+        static_voxels.clear();
+        static_voxels.set_offset(voxel_offset);
+    }
+    static_broadphase = type;
+    rebuild_static_broadphase();
+}
+
+void phys::PhysicsSystem::rebuild_static_broadphase()
+{
+    std::vector<StaticObject>& statics = static_objects.get_dense();
+
+    // Only the structure in use is kept up to date, the other one is dropped.
+    static_hash.clear();
+    static_bvh.clear();
+    static_voxels.clear();
+
+    switch (static_broadphase)
+    {
+        case StaticBroadphase::spatial_hash:
+            for (size_t i = 0; i < statics.size(); i++)
+            {
+                static_hash.insert(static_objects.get_associated_handle(i), statics[i].position - statics[i].half_extents,
+                                   statics[i].position + statics[i].half_extents);
+            }
+            break;
+        case StaticBroadphase::bvh:
+        {
+            std::vector<BVHItem> items(statics.size());
+            for (size_t i = 0; i < statics.size(); i++)
+            {
+                items[i] = { static_objects.get_associated_handle(i), statics[i].position - statics[i].half_extents,
+                             statics[i].position + statics[i].half_extents };
+            }
+            static_bvh.build(std::move(items));
+            break;
+        }
+        case StaticBroadphase::voxel_grid:
+            for (size_t i = 0; i < statics.size(); i++)
+            {
+                static_voxels.insert(static_objects.get_associated_handle(i), statics[i].position);
+            }
+            break;
+    }
+}
+
+void phys::PhysicsSystem::query_statics(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const
+{
+    switch (static_broadphase)
+    {
+        case StaticBroadphase::spatial_hash:
+            static_hash.query(min, max, out);
+            break;
+        case StaticBroadphase::bvh:
+            static_bvh.query(min, max, out);
+            break;
+        case StaticBroadphase::voxel_grid:
+            static_voxels.query(min, max, out);
+            break;
+    }
+}
+
+const glm::vec3 phys::PhysicsSystem::get_overlap(const glm::vec3& pos1, const glm::vec3& half_extents1, const glm::vec3& pos2, const glm::vec3& half_extents2) const
 {
     // https://www.youtube.com/watch?v=9QgaLWBkv0s
     // Get the volume of a potential overlap volume
     glm::vec3 delta = glm::abs(pos1 - pos2);
-    float overlap_x = half_width + half_width - delta.x; // technically, this is w1/2 + w2/2 - dx
-    float overlap_y = half_width + half_width - delta.y;
-    float overlap_z = half_width + half_width - delta.z;
+    return half_extents1 + half_extents2 - delta; // w1/2 + w2/2 - dx on each axis
+}
 
-    return glm::vec3(overlap_x, overlap_y, overlap_z);
+const bool phys::PhysicsSystem::are_colliding(const phys::DynamicObjectRef& a, phys::StaticObject b) const
+{
+    return collide_shapes(a.shape, a.position, a.half_extents, b.shape, b.position, b.half_extents).depth > 0.0f;
 }
 
-const bool phys::PhysicsSystem::are_colliding(phys::DynamicObject& a, phys::StaticObject b) const
+const bool phys::PhysicsSystem::are_colliding(const phys::DynamicObjectRef& a, const phys::DynamicObjectRef& b) const
 {
-    float half_width = 0.5f; // need to add this as an attribute of the objects
+    return collide_shapes(a.shape, a.position, a.half_extents, b.shape, b.position, b.half_extents).depth > 0.0f;
+}
 
-    glm::vec3 overlap = get_overlap(a.position, b.position, half_width);
+bool phys::PhysicsSystem::sweep_against_static(const glm::vec3& from, const glm::vec3& to, const glm::vec3& half_extents,
+                                               const glm::vec3& static_position, const glm::vec3& static_half_extents,
+                                               float& time_of_impact, int& axis) const
+{
+    // Slab test of the moving centre against the static grown by the dynamic's
+    // half extents, which is the same as moving the whole box against the static.
+    glm::vec3 move    = to - from;
+    glm::vec3 reach   = half_extents + static_half_extents;
+    float     t_enter = -std::numeric_limits<float>::infinity();
+    float     t_exit  = std::numeric_limits<float>::infinity();
+    int       enter_axis = -1;
 
-    if (overlap.x > 0.0f and // Collision when the overlap volume exists in positive space
-        overlap.y > 0.0f and
-        overlap.z > 0.0f)
+    for (int i = 0; i < 3; i++)
     {
-        return true;
+        float near_face = static_position[i] - reach[i];
+        float far_face  = static_position[i] + reach[i];
+        if (move[i] == 0.0f)
+        {
+            // Not moving on this axis, so it has to be inside the slab the whole time.
+            if (from[i] <= near_face or from[i] >= far_face)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float t0 = (near_face - from[i]) / move[i];
+        float t1 = (far_face - from[i]) / move[i];
+        if (t0 > t1)
+        {
+            std::swap(t0, t1);
+        }
+        if (t0 > t_enter)
+        {
+            t_enter    = t0;
+            enter_axis = i;
+        }
+        t_exit = std::min(t_exit, t1);
+    }
+
+    if (enter_axis < 0 or t_enter >= t_exit or t_enter < 0.0f or t_enter > 1.0f)
+    {
+        return false;
+    }
+    time_of_impact = t_enter;
+    axis           = enter_axis;
+    return true;
+}
+
+bool phys::PhysicsSystem::is_static_face_covered(const glm::vec3& static_position, const glm::vec3& static_half_extents, int axis,
+                                                 float direction, const CandidateGroup& boxes) const
+{
+    for (size_t i = 0; i < boxes.positions.size(); i++)
+    {
+        const glm::vec3& neighbour        = boxes.positions[i];
+        const glm::vec3& neighbour_extent = boxes.half_extents[i];
+        if (neighbour[axis] != static_position[axis] - direction * (static_half_extents[axis] + neighbour_extent[axis]))
+        {
+            continue;
+        }
+
+        // Flush against the face, now it has to reach past both of its other edges.
+        int  u       = (axis + 1) % 3;
+        int  v       = (axis + 2) % 3;
+        bool covers  = glm::abs(neighbour[u] - static_position[u]) + static_half_extents[u] <= neighbour_extent[u]
+                   and glm::abs(neighbour[v] - static_position[v]) + static_half_extents[v] <= neighbour_extent[v];
+        if (covers)
+        {
+            return true;
+        }
     }
     return false;
 }
 
-void phys::PhysicsSystem::step(float delta_time)
-// Let's cook this bad boy up with CUDA to accelerate the computing
+int phys::PhysicsSystem::choose_static_contact_axis(const glm::vec3& position, const glm::vec3& static_position, const glm::vec3& static_half_extents,
+                                                   const glm::vec3& overlap, const CandidateGroup& boxes) const
 {
-    double start_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    // Axes from least to most overlap.
+    int order[3] = { 0, 1, 2 };
+    if (overlap[order[1]] < overlap[order[0]]) std::swap(order[0], order[1]);
+    if (overlap[order[2]] < overlap[order[1]]) std::swap(order[1], order[2]);
+    if (overlap[order[1]] < overlap[order[0]]) std::swap(order[0], order[1]);
 
-    for (DynamicObject& a : dynamic_objects.get_dense())
+    // Skip faces of the static that another static sits against. A box sliding
+    // over a floor of blocks dips a little into the next block at each seam,
+    // and pushing it back out sideways would make it catch on every one.
+    // The neighbour touches the body too, so it is among the candidates.
+    for (int axis : order)
     {
-        // Accumulate gravity as a force. other forces (like thrust,
-        // collisions, etc.) are added elsewhere
-        a.force += a.mass * gravity;
+        float direction = (static_position[axis] >= position[axis]) ? 1.0f : -1.0f;
+        if (not is_static_face_covered(static_position, static_half_extents, axis, direction, boxes))
+        {
+            return axis;
+        }
+    }
 
-        // Newton's second law: a = f/m
-        // Integrates acceleration into velocity. This is the semi - implicit
-        // Euler method, which is more stable than simple(explicit) Euler.
-        a.velocity += (a.force / a.mass) * delta_time;
+    // Buried on every side, so any way out is as good as another.
+    return order[0];
+}
 
-        glm::vec3 old_position = a.position;
+void phys::PhysicsSystem::find_static_contacts(const JobRange& range)
+{
+    AlignedVector<glm::vec3>& positions    = dynamic_objects.get_field<POSITION>();
+    AlignedVector<glm::vec3>& half_extents = dynamic_objects.get_field<HALF_EXTENTS>();
+    AlignedVector<ShapeType>& shapes       = dynamic_objects.get_field<SHAPE>();
 
-        a.position += a.velocity * delta_time;
+    std::vector<uint32_t>& candidates = static_candidates[range.worker];
+    CandidateContacts&     found      = candidate_contacts[range.worker];
+    std::vector<Contact>&  contacts   = chunk_contacts[range.chunk]; // only this job touches it
+    contacts.clear();
 
-        a.force = glm::vec3(0.0f);
+    CandidateGroup& boxes = found.groups[size_t(ShapeType::aabb)];
+    for (size_t i = range.begin; i < range.end; i++)
+    {
+        const glm::vec3& position = positions[i];
+        const glm::vec3& extent   = half_extents[i];
+        ShapeType        shape    = shapes[i];
+        uint32_t         id       = dynamic_objects.get_associated_handle(i);
+        query_statics(position - extent, position + extent, candidates);
 
-        for (StaticObject& b : static_objects.get_dense())
+        // Sort the candidates by shape into contiguous arrays, so each group
+        // goes through one kernel and the kernels can test several per instruction.
+        size_t group_sizes[SHAPE_TYPE_COUNT] = {};
+        for (uint32_t static_handle : candidates)
         {
-            if (are_colliding(a, b))
-            {
-                std:: cout << "collision" << std::endl;
+            group_sizes[size_t(static_objects.get(static_handle).shape)]++;
+        }
+        for (size_t k = 0; k < SHAPE_TYPE_COUNT; k++)
+        {
+            found.groups[k].handles.resize(group_sizes[k]);
+            found.groups[k].positions.resize(group_sizes[k]);
+            found.groups[k].half_extents.resize(group_sizes[k]);
+            group_sizes[k] = 0;
+        }
+        for (uint32_t static_handle : candidates)
+        {
+            const StaticObject& object = static_objects.get(static_handle);
+            CandidateGroup&     group  = found.groups[size_t(object.shape)];
+            size_t              slot   = group_sizes[size_t(object.shape)]++;
+            group.handles[slot]      = static_handle;
+            group.positions[slot]    = object.position;
+            group.half_extents[slot] = object.half_extents;
+        }
 
-                float half_width = 0.5f; // need to add this as an attribute of the objects
+        // Box bodies against box statics is the common case. It gets the
+        // vector kernel, and skips faces hidden by a neighbouring static.
+        size_t box_count = (shape == ShapeType::aabb) ? boxes.positions.size() : 0;
+        found.depths.resize(box_count);
+        found.axes.resize(box_count);
+        found.directions.resize(box_count);
+        find_box_contacts(position, extent, boxes.positions.data(), boxes.half_extents.data(), box_count,
+                          found.depths.data(), found.axes.data(), found.directions.data());
 
-                glm::vec3 overlap = get_overlap(a.position, b.position, half_width);
+        for (size_t k = 0; k < box_count; k++)
+        {
+            if (found.depths[k] <= 0.0f)
+            {
+                continue;
+            }
 
-                glm::vec3 previous_overlap = get_overlap(old_position, b.position, half_width);
+            const glm::vec3& static_position = boxes.positions[k];
+            const glm::vec3& static_extent   = boxes.half_extents[k];
+            int   axis      = found.axes[k];
+            float direction = found.directions[k];
+            float depth     = found.depths[k];
+            if (is_static_face_covered(static_position, static_extent, axis, direction, boxes))
+            {
+                glm::vec3 overlap = get_overlap(position, extent, static_position, static_extent);
+                axis      = choose_static_contact_axis(position, static_position, static_extent, overlap, boxes);
+                direction = (static_position[axis] >= position[axis]) ? 1.0f : -1.0f;
+                depth     = overlap[axis];
+            }
 
-                float e = 0.6f; // Coefficient of Restitution
-                // e = -((v1-v2)/(V1-V2))
-                //float u = 0.3f; // Ff = u * N (force of friction is equals coefficient of friction * normal force)
+            glm::vec3 normal = glm::vec3(0.0f); // points from the body to the static
+            normal[axis] = direction;
 
-                //float h = 0.50f;  // F = mv/2h
+            contacts.push_back({ uint32_t(i), INVALID_HANDLE, id, boxes.handles[k], normal, depth, axis });
+        }
 
-                //glm::vec3 total_force = a.mass
-                //    * glm::vec3(a.velocity.x * a.velocity.x, a.velocity.y * a.velocity.y, a.velocity.z * a.velocity.z)
-                //    / (2.0f * h);
+        // Every other pairing goes through the kernel built for its two shapes.
+        for (size_t static_shape = 0; static_shape < SHAPE_TYPE_COUNT; static_shape++)
+        {
+            CandidateGroup& group = found.groups[static_shape];
+            if (group.handles.empty() or (shape == ShapeType::aabb and static_shape == size_t(ShapeType::aabb)))
+            {
+                continue;
+            }
 
-                if (previous_overlap.y > 0.0f and previous_overlap.z > 0.0f) // X FACE COLLISIONS
-                {
-                    if (a.position.x > b.position.x)      // Left Face Collision
-                    {
-                        a.position.x += overlap.x;
-                    }
-                    else if (a.position.x < b.position.x) // Right Face Collision
-                    {
-                        a.position.x -= overlap.x;
-                    }
-                    else
-                    {
-                        // TODO
-                    }
-                    a.velocity.x = -a.velocity.x * e;
-                    //float N = -total_force.x;
-                    //std:: cout << "Normal Force " << N << std::endl;
-                    //std:: cout << "warning!" << std::endl;
-                    //float Ff = u * N;
-                    //a.force.y += Ff;
+            group.contacts.resize(group.handles.size());
+            SHAPE_BATCH_KERNELS[shape_pair_index(shape, ShapeType(static_shape))]
+                (position, extent, group.positions.data(), group.half_extents.data(), group.handles.size(), group.contacts.data());
 
-                }
-                else if (previous_overlap.x > 0.0f and previous_overlap.z > 0.0f) // Y FACE COLLISIONS
-                {
-
-                    if (a.position.y > b.position.y) // Bottom Face
-                    {
-                        a.position.y += overlap.y;
-
-                    }
-                    else if (a.position.y < b.position.y) // Top Face
-                    {
-                        a.position.y -= overlap.y;
-                    }
-                    else
-                    {
-                        // TODO
-                    }
-                    a.velocity.y = -a.velocity.y * e;
-
-                    //float N = 0.0f;
-                    //if (a.velocity.y > 0)
-                    //{
-                    //    N = -total_force.y;
-                    //}
-                    //else
-                    //{
-                    //    N = total_force.y;
-                    //}
-                    //a.force.x += N;
-
-                    //float Ff = u * N;
-                    //a.force.x += Ff;
-
-                    //std::cout << "Normal Force " << N << std::endl;
-                    //std::cout << a.velocity.y << std::endl;
-                    //std::string message1 = std::format(" force x,y,z: {},{},{}", a.force.x, a.force.y, a.force.z);
-                    //std::cout << message1 << std::endl;
-                }
-                else if (previous_overlap.y > 0.0f and previous_overlap.x > 0.0f) // Z FACE COLLISIONS
-                {
-                    if (a.position.z > b.position.z) // Back Face Collision
-                    {
-                        a.position.z += overlap.z;
-                    }
-                    else if (a.position.z < b.position.z) // Front Face Collision
-                    {
-                        a.position.z -= overlap.z;
-                    }
-                    else
-                    {
-                        // TODO
-                    }
-                    a.velocity.z = -a.velocity.z * e;
-                }
-                else if (previous_overlap.x <= 0.0f and // no x or y overlap previously,   //  right and left edges
-                    previous_overlap.y <= 0.0f and
-                    previous_overlap.z > 0.0f)
+            for (size_t k = 0; k < group.handles.size(); k++)
+            {
+                const ShapeContact& contact = group.contacts[k];
+                if (contact.depth > 0.0f)
                 {
-                    if (a.position.x > b.position.x)
-                    {
-                        if (a.position.y < b.position.y) // Top left edge
-                        {
-                            // Default to moving down.
-                            a.position.y -= overlap.y;
-                        }
-                        else if (a.position.y > b.position.y) // bottom left edge
-                        {
-                            // Default to moving up.
-                            a.position.y += overlap.y;
-                        }
-
-                    }
-                    else if (a.position.x < b.position.x)
-                    {
-                        if (a.position.y < b.position.y) // Top right edge
-                        {
-                            // Default to moving down.
-                            a.position.y -= overlap.y;
-                        }
-                        else if (a.position.y > b.position.y) // bottom right edge
-                        {
-                            // Default to moving up.
-                            a.position.y += overlap.y;
-                        }
-                    }
-                    a.velocity.y = -a.velocity.y * e;
+                    contacts.push_back({ uint32_t(i), INVALID_HANDLE, id, group.handles[k], contact.normal, contact.depth, contact.axis });
                 }
-                else if (previous_overlap.z <= 0.0f and // no x or y overlap previously,   //  right and left edges
-                         previous_overlap.y <= 0.0f and
-                         previous_overlap.x > 0.0f)
-                {
-                    if (a.position.z > b.position.z)
-                    {
-                        if (a.position.y < b.position.y) // Top front edge
-                        {
-                            // Default to moving down.
-                            a.position.y -= overlap.y;
-                        }
-                        else if (a.position.y > b.position.y) // bottom front edge
-                        {
-                            // Default to moving up.
-                            a.position.y += overlap.y;
-                        }
-                    }
-                    else if (a.position.z < b.position.z)
-                    {
-                        if (a.position.y < b.position.y) // Top back edge
-                        {
-                            // Default to moving down.
-                            a.position.y -= overlap.y;
-                        }
-                        else if (a.position.y > b.position.y) // bottom back edge
-                        {
-                            // Default to moving up.
-                            a.position.y += overlap.y;
-                        }
-                    }
-                    a.velocity.y = -a.velocity.y * e;
+            }
+        }
+    }
+}
 
-                }
-                // TODO those 4 vertical edges
-                else
-                {
-                    std::string message1 = std::format("Unplanned situtation. previous overlap x,y,z: {},{},{}", previous_overlap.x, previous_overlap.y, previous_overlap.z);
-                    std::string message2 = std::format("Unplanned situtation. overlap x,y,z: {},{},{}", overlap.x, overlap.y, overlap.z);
-                    std::cout << message1 << std::endl;
-                    std::cout << message2 << std::endl;
-                    throw std::runtime_error("Need to implement!");
-                }
+void phys::PhysicsSystem::stop_static_tunneling(const JobRange& range)
+{
+    AlignedVector<glm::vec3>& positions    = dynamic_objects.get_field<POSITION>();
+    AlignedVector<glm::vec3>& velocities   = dynamic_objects.get_field<VELOCITY>();
+    AlignedVector<glm::vec3>& half_extents = dynamic_objects.get_field<HALF_EXTENTS>();
+
+    std::vector<uint32_t>&       candidates = static_candidates[range.worker];
+    std::vector<CollisionEvent>& events     = chunk_events[range.chunk]; // only this job touches it
+    events.clear();
+
+    for (size_t i = range.begin; i < range.end; i++)
+    {
+        glm::vec3&       position     = positions[i];
+        const glm::vec3& old_position = previous_positions[i];
+        const glm::vec3& extent       = half_extents[i];
+
+        // Only the statics near the swept box can be touched this step.
+        query_statics(glm::min(old_position, position) - extent, glm::max(old_position, position) + extent, candidates);
+
+        // A body fast enough to get past the middle of a static in one step is
+        // either out the far side, where next step's contacts never see it, or
+        // would be pushed out the far side by them. Find the first static the
+        // swept box enters like that and stop the body against the face it hit.
+        float    first_impact = std::numeric_limits<float>::infinity();
+        int      first_axis   = -1;
+        uint32_t first_static = INVALID_HANDLE;
+        for (uint32_t static_handle : candidates)
+        {
+            const StaticObject& object          = static_objects.get(static_handle);
+            const glm::vec3&    static_position = object.position;
+            float time_of_impact;
+            int   axis;
+            if (sweep_against_static(old_position, position, extent, static_position, object.half_extents, time_of_impact, axis)
+                and time_of_impact < first_impact
+                and (old_position[axis] < static_position[axis]) != (position[axis] < static_position[axis]))
+            {
+                first_impact = time_of_impact;
+                first_axis   = axis;
+                first_static = static_handle;
             }
         }
 
+        if (first_static == INVALID_HANDLE)
+        {
+            continue;
+        }
+
+        const glm::vec3& static_position = static_objects.get(first_static).position;
+        const glm::vec3& static_extent   = static_objects.get(first_static).half_extents;
+        DynamicID        dynamic_id      = DynamicID(dynamic_objects.get_associated_handle(i));
+        PHYS_LOG_TRACE("collision: dynamic {} swept into static {} at t = {}", static_cast<uint32_t>(dynamic_id), first_static, first_impact);
+
+        // Back up to the time of impact, then snap onto the face with a
+        // small gap so rounding can't leave the boxes overlapping.
+        constexpr float skin = 1e-4f;
+        float side = (old_position[first_axis] < static_position[first_axis]) ? -1.0f : 1.0f;
+        position = old_position + (position - old_position) * first_impact;
+        position[first_axis] = static_position[first_axis] + side * (extent[first_axis] + static_extent[first_axis] + skin);
+
+        velocities[i][first_axis] = -velocities[i][first_axis] * contact_solver.get_restitution();
+
+        events.push_back({ dynamic_id, first_axis == 0, first_axis == 1, first_axis == 2, first_static, false });
     }
-    double end_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    double duration = end_time - start_time;
-    std::cout << std::to_string(duration * (double)1000) << "ms" << std::endl;
 }
 
-void phys::PhysicsSystem::debug_objects()
+void phys::PhysicsSystem::step(float delta_time)
+// Let's cook this bad boy up with CUDA to accelerate the computing
 {
-    size_t i = 0;
-    for (auto& dyn_obj : dynamic_objects.get_dense())
+    [[maybe_unused]] double start_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+
+    AlignedVector<glm::vec3>& positions  = dynamic_objects.get_field<POSITION>();
+    AlignedVector<glm::vec3>& velocities = dynamic_objects.get_field<VELOCITY>();
+    AlignedVector<glm::vec3>& forces     = dynamic_objects.get_field<FORCE>();
+    AlignedVector<float>&     masses     = dynamic_objects.get_field<MASS>();
+    AlignedVector<glm::vec3>& extents    = dynamic_objects.get_field<HALF_EXTENTS>();
+    AlignedVector<ShapeType>& shapes     = dynamic_objects.get_field<SHAPE>();
+
+    static_candidates.resize(job_system->get_thread_count());
+    candidate_contacts.resize(job_system->get_thread_count());
+
+    // Contacts are found where the bodies are at the start of the step, the
+    // solver then picks velocities that keep them from going any deeper.
+
+    // Dynamic vs dynamic. Bounds are refreshed from the current positions and
+    // the sweep finds the overlapping pairs without testing every pair of bodies.
+    dynamic_sap.update([this, &positions, &extents](uint32_t handle, glm::vec3& min, glm::vec3& max)
     {
-        DynamicID id = DynamicID(dynamic_objects.get_associated_handle(i));
-        std::cout << "DynamicID: " << std::to_string(id) << std::endl;
+        // Sleeping bodies haven't moved, their bounds are still right.
+        uint32_t index = dynamic_objects.get_dense_index(handle);
+        if (index < awake_count)
+        {
+            min = positions[index] - extents[index];
+            max = positions[index] + extents[index];
+        }
+    });
+    dynamic_sap.find_active_pairs(dynamic_pairs, [this](uint32_t handle)
+    {
+        return dynamic_objects.get_dense_index(handle) < awake_count;
+    });
+
+    // Being hit wakes a sleeping body along with the rest of its island. Waking
+    // moves bodies around in the dense arrays, so it all happens before any
+    // contact records a dense index.
+    for (auto& [handle_a, handle_b] : dynamic_pairs)
+    {
+        bool awake_a = dynamic_objects.get_dense_index(handle_a) < awake_count;
+        bool awake_b = dynamic_objects.get_dense_index(handle_b) < awake_count;
+        if (awake_a != awake_b and are_colliding(get_dynamic(DynamicID(handle_a)), get_dynamic(DynamicID(handle_b))))
+        {
+            wake(DynamicID(awake_a ? handle_b : handle_a));
+        }
+    }
+
+    // Dynamic vs static first, including anything woken above. Solving the
+    // contacts at the bottom of a stack before the ones resting on them gets
+    // each iteration further up the stack. Every chunk writes to its own
+    // buffer, so no locks are needed, and appending them in chunk order gives
+    // the same contact order on any thread count in deterministic mode.
+    size_t count       = awake_count;
+    size_t chunk_size  = chunk_size_for(count);
+    size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+    if (chunk_contacts.size() < chunk_count)
+    {
+        chunk_contacts.resize(chunk_count);
+        chunk_events.resize(chunk_count);
+    }
+
+    job_system->parallel_for(count, chunk_size, [this](const JobRange& range)
+    {
+        find_static_contacts(range);
+    });
+
+    contact_solver.clear();
+    std::vector<Contact>& contacts = contact_solver.get_contacts();
+    for (size_t chunk = 0; chunk < chunk_count; chunk++)
+    {
+        contacts.insert(contacts.end(), chunk_contacts[chunk].begin(), chunk_contacts[chunk].end());
+    }
+    size_t static_contact_count = contacts.size();
+
+    // Then dynamic vs dynamic, from the pairs the sweep found, grouped by the
+    // shapes involved so each group runs through its own kernel.
+    for (auto& pairs : shape_pairs)
+    {
+        pairs.clear();
+    }
+    for (auto [handle_a, handle_b] : dynamic_pairs)
+    {
+        // Ordered by ID so the pair finds its cached impulse whichever way round the sweep reports it.
+        if (handle_b < handle_a)
+        {
+            std::swap(handle_a, handle_b);
+        }
+        uint32_t index_a = dynamic_objects.get_dense_index(handle_a);
+        uint32_t index_b = dynamic_objects.get_dense_index(handle_b);
+        if (index_a >= awake_count or index_b >= awake_count)
+        {
+            continue;
+        }
+        shape_pairs[shape_pair_index(shapes[index_a], shapes[index_b])].push_back({ index_a, index_b });
+    }
+
+    for (size_t kernel = 0; kernel < shape_pairs.size(); kernel++)
+    {
+        const auto& pairs = shape_pairs[kernel];
+        shape_pair_contacts.resize(pairs.size());
+        SHAPE_PAIR_KERNELS[kernel](positions.data(), extents.data(), pairs.data(), pairs.size(), shape_pair_contacts.data());
+
+        for (size_t k = 0; k < pairs.size(); k++)
+        {
+            const ShapeContact& found = shape_pair_contacts[k];
+            if (found.depth <= 0.0f)
+            {
+                continue;
+            }
+
+            auto [index_a, index_b] = pairs[k];
+            contacts.push_back({ index_a, index_b, dynamic_objects.get_associated_handle(index_a), dynamic_objects.get_associated_handle(index_b),
+                                 found.normal, found.depth, found.axis });
+        }
+    }
+
+    // Gravity, force -> velocity -> position, and the force reset, several bodies at a time.
+    // Each body only depends on itself, so chunks can run on any thread.
+    job_system->parallel_for(count, chunk_size, [&](const JobRange& range)
+    {
+        std::copy(positions.begin() + range.begin, positions.begin() + range.end, previous_positions.begin() + range.begin);
+
+        integrate_bodies(positions.data() + range.begin, velocities.data() + range.begin, forces.data() + range.begin,
+                         masses.data() + range.begin, range.end - range.begin, gravity, delta_time);
+    });
+
+    // The solver only changes velocities. Bodies it touched are moved again
+    // from where they started with their new velocity, exactly as if it had
+    // run between the two halves of the integration, plus whatever it took to
+    // push them out of what they were sinking into.
+    push_velocities.resize(dynamic_objects.size());
+    contact_solver.solve(velocities.data(), push_velocities.data(), masses.data(), delta_time);
+    for (const Contact& contact : contacts)
+    {
+        positions[contact.body_a] = previous_positions[contact.body_a] + (velocities[contact.body_a] + push_velocities[contact.body_a]) * delta_time;
+        if (contact.body_b != INVALID_HANDLE)
+        {
+            positions[contact.body_b] = previous_positions[contact.body_b] + (velocities[contact.body_b] + push_velocities[contact.body_b]) * delta_time;
+        }
+    }
+
+    // Events list dynamic pairs first, the same as before the solver existed.
+    collision_events.clear();
+    contact_links.clear();
+    for (size_t i = static_contact_count; i < contacts.size(); i++)
+    {
+        const Contact& contact = contacts[i];
+        PHYS_LOG_TRACE("collision: dynamic {} with dynamic {}", contact.id_a, contact.id_b);
+        collision_events.push_back({ DynamicID(contact.id_a), contact.axis == 0, contact.axis == 1, contact.axis == 2, contact.id_b, true });
+        contact_links.emplace_back(contact.id_a, contact.id_b);
+    }
+    for (size_t i = 0; i < static_contact_count; i++)
+    {
+        const Contact& contact = contacts[i];
+        PHYS_LOG_TRACE("collision: dynamic {} with static {}", contact.id_a, contact.id_b);
+        collision_events.push_back({ DynamicID(contact.id_a), contact.axis == 0, contact.axis == 1, contact.axis == 2, contact.id_b, false });
+    }
+
+    // Contacts only stop bodies that already touch, so one fast enough to get
+    // through a static within this step is caught against its swept path.
+    job_system->parallel_for(count, chunk_size, [this](const JobRange& range)
+    {
+        stop_static_tunneling(range);
+    });
+    for (size_t chunk = 0; chunk < chunk_count; chunk++)
+    {
+        collision_events.insert(collision_events.end(), chunk_events[chunk].begin(), chunk_events[chunk].end());
+    }
 
-        std::string message1 = std::format("Position: ({}, {}, {})", dyn_obj.position.x, dyn_obj.position.y, dyn_obj.position.z);
-        std::cout << message1 << std::endl;
+    update_sleep(delta_time);
 
-        std::string message2 = std::format("Velocity: ({}, {}, {})m/s",
-            dyn_obj.velocity.x, dyn_obj.velocity.y, dyn_obj.velocity.z);
-        std::cout << message2 << std::endl << std::endl;
+    [[maybe_unused]] double end_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    [[maybe_unused]] double duration = end_time - start_time;
+    PHYS_LOG_DEBUG("step: {:.3f}ms", duration * 1000.0);
+}
+
+std::span<const phys::CollisionEvent> phys::PhysicsSystem::get_collision_events() const
+{
+    return collision_events;
+}
 
-        i++;
+void phys::PhysicsSystem::write_snapshot(PhysicsSnapshot& snapshot) const
+{
+    const auto& positions = dynamic_objects.get_field<POSITION>();
+    size_t      count     = dynamic_objects.size();
+
+    uint32_t index_end = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        index_end = std::max(index_end, handle_index(dynamic_objects.get_associated_handle(i)) + 1);
     }
+    snapshot.positions.resize(index_end);
+    snapshot.previous_positions.resize(index_end);
 
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t index = handle_index(dynamic_objects.get_associated_handle(i));
+        snapshot.positions[index]          = positions[i];
+        snapshot.previous_positions[index] = previous_positions[i];
+    }
+}
+
+void phys::PhysicsSystem::snapshot(WorldSnapshot& out) const
+{
+    out.bytes.clear();
+    SnapshotWriter writer(out.bytes);
+
+    writer.write_value(WORLD_SNAPSHOT_VERSION);
+    writer.write_value(uint32_t(static_broadphase));
+    writer.write_value(static_voxels.get_offset());
+    static_objects.save(writer);
+
+    writer.write_value<uint8_t>(sleeping_enabled);
+    writer.write_value<uint64_t>(awake_count);
+    writer.write_value(next_island);
+    dynamic_objects.save(writer);
+    writer.write_vector(previous_positions);
+    dynamic_sap.save(writer);
+    contact_solver.save(writer);
+}
+
+void phys::PhysicsSystem::restore(const WorldSnapshot& snapshot)
+{
+    SnapshotReader reader(snapshot.bytes);
+
+    if (reader.read_value<uint32_t>() != WORLD_SNAPSHOT_VERSION)
+    {
+        throw std::runtime_error("phys::PhysicsSystem::restore() failed. The snapshot is from a different version.");
+    }
+    uint32_t  broadphase   = reader.read_value<uint32_t>();
+    glm::vec3 voxel_offset = reader.read_value<glm::vec3>();
+    if (broadphase > uint32_t(StaticBroadphase::voxel_grid))
+    {
+        throw std::runtime_error("phys::PhysicsSystem::restore() failed. The snapshot names an unknown broadphase.");
+    }
+
+    // Everything is loaded on the side first, the world is untouched until it all checks out.
+    restore_statics.load(reader);
+    bool     sleeping  = reader.read_value<uint8_t>() != 0;
+    uint64_t awake     = reader.read_value<uint64_t>();
+    uint32_t island    = reader.read_value<uint32_t>();
+    restore_dynamics.load(reader);
+    reader.read_vector(restore_previous_positions);
+    restore_sap.load(reader);
+    size_t solver_position = reader.get_position();
+    restore_solver.load(reader);
+
+    bool sap_matches = restore_sap.matches(restore_dynamics.size(), [this](uint32_t handle)
+    {
+        return restore_dynamics.get_dense_index(handle);
+    });
+    if (not reader.at_end() or awake > restore_dynamics.size() or restore_previous_positions.size() != restore_dynamics.size() or
+        not sap_matches)
+    {
+        throw std::runtime_error("phys::PhysicsSystem::restore() failed. The snapshot's sections don't fit together.");
+    }
+
+    std::vector<StaticObject>& statics     = static_objects.get_dense();
+    std::vector<StaticObject>& new_statics = restore_statics.get_dense();
+    bool statics_changed = statics.size() != new_statics.size();
+    for (size_t i = 0; i < statics.size() and not statics_changed; i++)
+    {
+        statics_changed = statics[i].position != new_statics[i].position or statics[i].half_extents != new_statics[i].half_extents or
+                          statics[i].shape != new_statics[i].shape or
+                          static_objects.get_associated_handle(i) != restore_statics.get_associated_handle(i);
+    }
+    bool rebuild = statics_changed or StaticBroadphase(broadphase) != static_broadphase or voxel_offset != static_voxels.get_offset();
+    if (rebuild and StaticBroadphase(broadphase) == StaticBroadphase::voxel_grid)
+    {
+        validate_voxel_statics(VoxelGrid(voxel_offset), new_statics, "restore");
+    }
+
+    // Nothing below throws.
+    std::swap(static_objects, restore_statics);
+    std::swap(dynamic_objects, restore_dynamics);
+    std::swap(previous_positions, restore_previous_positions);
+    std::swap(dynamic_sap, restore_sap);
+    SnapshotReader solver_reader(std::span<const std::byte>(snapshot.bytes).subspan(solver_position));
+    contact_solver.load(solver_reader);
+
+    sleeping_enabled = sleeping;
+    awake_count      = size_t(awake);
+    next_island      = island;
+
+    if (rebuild)
+    {
+        static_broadphase = StaticBroadphase(broadphase);
+        static_voxels.clear();
+        static_voxels.set_offset(voxel_offset);
+        rebuild_static_broadphase();
+    }
+
+    // From the step before the restore, which no longer happened.
+    collision_events.clear();
+}
+
+void phys::PhysicsSystem::debug_objects()
+{
+    // Formatting every body is only worth doing when the output is compiled in.
+#if PHYS_LOG_LEVEL <= PHYS_LOG_LEVEL_DEBUG
+    AlignedVector<glm::vec3>& positions  = dynamic_objects.get_field<POSITION>();
+    AlignedVector<glm::vec3>& velocities = dynamic_objects.get_field<VELOCITY>();
+
+    for (size_t i = 0; i < dynamic_objects.size(); i++)
+    {
+        DynamicID id = DynamicID(dynamic_objects.get_associated_handle(i));
+        PHYS_LOG_DEBUG("DynamicID: {}", static_cast<uint32_t>(id));
+        PHYS_LOG_DEBUG("Position: ({}, {}, {})", positions[i].x, positions[i].y, positions[i].z);
+        PHYS_LOG_DEBUG("Velocity: ({}, {}, {})m/s", velocities[i].x, velocities[i].y, velocities[i].z);
+    }
+#endif
 }
\ No newline at end of file
@@ -1,11 +1,31 @@
 #pragma once
 #include "SparseSet.hpp"
+#include "SoASparseSet.hpp"
+#include "SpatialHash.hpp"
+#include "StaticBVH.hpp"
+#include "VoxelGrid.hpp"
+#include "SweepAndPrune.hpp"
+#include "ContactSolver.hpp"
+#include "IntegrationKernel.hpp"
+#include "CollisionShapes.hpp"
+#include "JobSystem.hpp"
+#include "Log.hpp"
+#include "PhysicsSnapshot.hpp"
+#include "WorldSnapshot.hpp"
 
 #include <stdexcept>
 #include <iostream>
 #include <format>
 #include <vector>
+#include <array>
 #include <chrono>
+#include <utility>
+#include <memory>
+#include <span>
+#include <limits>
+#include <tuple>
+#include <algorithm>
+#include <string>
 
 #include <glm/glm.hpp>
 
@@ -13,6 +33,15 @@
 namespace phys
 {
 
+constexpr float OBJECT_HALF_WIDTH = 0.5f; // default half extent of every object, a unit box
+
+// A body is still while it moves slower than SLEEP_SPEED over a tick. Measured
+// from the change in position rather than velocity, because a box resting on
+// the floor bounces its velocity every tick while its position stays put.
+constexpr float    SLEEP_SPEED = 0.05f;
+constexpr uint32_t SLEEP_TICKS = 60;         // ticks an entire island must stay still for before it sleeps
+constexpr uint32_t NO_ISLAND   = 0xFFFFFFFF; // island of every awake body
+
 struct StaticID
 {
     uint32_t value;
@@ -39,11 +68,50 @@ struct DynamicObject
     glm::vec3 velocity;
     glm::vec3 force;
     float     mass;
+    glm::vec3 half_extents = glm::vec3(OBJECT_HALF_WIDTH);
+    ShapeType shape        = ShapeType::aabb;
+};
+
+/// <summary>
+/// References into the storage of one dynamic object. Dynamic objects are kept
+/// as a structure of arrays, so there is no DynamicObject in memory to point at.
+/// </summary>
+struct DynamicObjectRef
+{
+    glm::vec3& position;
+    glm::vec3& velocity;
+    glm::vec3& force;
+    float&     mass;
+    // Read only, the broadphase and the sleeping islands would need updating too.
+    const glm::vec3& half_extents;
+    const ShapeType& shape;
+};
+
+// Field order of the dynamic object storage in PhysicsSystem.
+enum DynamicField : size_t
+{
+    POSITION    = 0,
+    VELOCITY    = 1,
+    FORCE       = 2,
+    MASS        = 3,
+    STILL_TICKS  = 4, // consecutive ticks the body has been still for
+    ISLAND       = 5, // the sleeping island the body belongs to, NO_ISLAND while awake
+    HALF_EXTENTS = 6,
+    SHAPE        = 7
 };
 
 struct StaticObject
 {
     glm::vec3 position;
+    glm::vec3 half_extents = glm::vec3(OBJECT_HALF_WIDTH);
+    ShapeType shape        = ShapeType::aabb;
+};
+
+enum class StaticBroadphase
+{
+    spatial_hash, // uniform grid, best when statics are all about one cell in size
+    bvh,          // bounding volume hierarchy, scales with log(static count) for any layout
+    voxel_grid    // bit per cell occupancy, only for statics lined up on unit cells, cost independent of static count
 };
 
 struct CollisionEvent
@@ -52,35 +120,328 @@ struct CollisionEvent
     bool      is_x_plane;
     bool      is_y_plane;
     bool      is_z_plane;
+    uint32_t  other_id;         // a DynamicID if other_is_dynamic, otherwise a StaticID
+    bool      other_is_dynamic;
 };
 
 class PhysicsSystem
 {
     private:
-    SparseSet<DynamicObject> dynamic_objects;
+    SoASparseSet<glm::vec3, glm::vec3, glm::vec3, float, uint32_t, uint32_t, glm::vec3, ShapeType> dynamic_objects; // see DynamicField for the order
+    // Awake bodies are kept at the front of the dense arrays, so every per body
+    // pass in step() just stops at awake_count.
+    size_t                   awake_count      = 0;
+    bool                     sleeping_enabled = true;
+    uint32_t                 next_island      = 0;
     SparseSet<StaticObject>  static_objects;
+    StaticBroadphase         static_broadphase = StaticBroadphase::bvh;
+    SpatialHash              static_hash;
+    StaticBVH                static_bvh;
+    VoxelGrid                static_voxels;
+    std::vector<std::vector<uint32_t>> static_candidates; // one per worker, reused every step so queries don't allocate
+
+    // The candidates of one query that share a shape type, gathered into
+    // contiguous arrays for the contact kernels.
+    struct CandidateGroup
+    {
+        std::vector<uint32_t>     handles;
+        std::vector<glm::vec3>    positions;
+        std::vector<glm::vec3>    half_extents;
+        std::vector<ShapeContact> contacts; // from SHAPE_BATCH_KERNELS
+    };
+    // One per worker, like static_candidates.
+    struct CandidateContacts
+    {
+        std::array<CandidateGroup, SHAPE_TYPE_COUNT> groups;     // by ShapeType
+        std::vector<float>                           depths;     // find_box_contacts() output, box vs box only
+        std::vector<int32_t>                         axes;
+        std::vector<float>                           directions;
+    };
+    std::vector<CandidateContacts> candidate_contacts;
+    SweepAndPrune            dynamic_sap;
+    std::vector<std::pair<uint32_t, uint32_t>> dynamic_pairs;
+    // This step's dynamic pairs as dense indices, one list per pair of shape
+    // types (see shape_pair_index()), so each list runs through one kernel.
+    std::array<std::vector<std::pair<uint32_t, uint32_t>>, SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT> shape_pairs;
+    std::vector<ShapeContact>                  shape_pair_contacts;
+    std::vector<uint32_t>    batch_handles;      // scratch for the bulk add/remove calls
+    std::vector<glm::vec3>   previous_positions; // position of each dense dynamic before this step's integration, kept in step with dynamic_objects
+
+    // Scratch for finding islands at the end of a step, indexed by dense index.
+    std::vector<std::pair<uint32_t, uint32_t>> contact_links; // handles of every dynamic pair that touched this step
+    std::vector<uint32_t>                      island_parents;
+    std::vector<uint32_t>                      island_roots_still; // per root, 1 if every body under it is ready to sleep
+    std::vector<uint32_t>                      sleep_islands;
+
+    ContactSolver                            contact_solver;
+    std::vector<std::vector<Contact>>        chunk_contacts;   // one per narrowphase chunk, merged into the solver's contacts
+    std::vector<glm::vec3>                   push_velocities;  // scratch for the solver, by dense index
+
+    std::vector<CollisionEvent>              collision_events; // everything from the last step, contiguous
+    std::vector<std::vector<CollisionEvent>> chunk_events;     // one per narrowphase chunk, merged into collision_events
+
+    // restore() loads a snapshot into these first and only swaps them in once
+    // all of it checked out. Kept between calls so restores don't reallocate.
+    decltype(dynamic_objects) restore_dynamics;
+    SparseSet<StaticObject>   restore_statics;
+    std::vector<glm::vec3>    restore_previous_positions;
+    SweepAndPrune             restore_sap;
+    ContactSolver             restore_solver;
 
     glm::vec3                gravity          = glm::vec3(0.0f, -9.806f, 0.0f);
 
+    std::shared_ptr<JobSystem> job_system;
+    bool                       deterministic    = true;
+
+    static constexpr size_t    DETERMINISTIC_CHUNK_SIZE = 256;
+
+    /// <summary>
+    /// How many bodies go in one job. Deterministic mode always uses the same size
+    /// so work splits the same way, and per-chunk results merge in the same order,
+    /// whatever the thread count. Otherwise chunks are sized to the pool.
+    /// </summary>
+    size_t chunk_size_for(size_t count) const;
+
+    /// <summary>
+    /// Axis a box should be pushed out of an overlapping box static along: the
+    /// one of least overlap, unless that face of the static is covered by
+    /// another box static from the candidates.
+    /// </summary>
+    int choose_static_contact_axis(const glm::vec3& position, const glm::vec3& static_position, const glm::vec3& static_half_extents,
+                                   const glm::vec3& overlap, const CandidateGroup& boxes) const;
+
+    /// <summary>
+    /// True if one of the box candidates sits flush against the face of the
+    /// static pointing along -direction on axis and covers all of it, i.e. the
+    /// face a body on that side would be pushed out through.
+    /// </summary>
+    bool is_static_face_covered(const glm::vec3& static_position, const glm::vec3& static_half_extents, int axis, float direction,
+                                const CandidateGroup& boxes) const;
+
+    /// <summary>
+    /// Dynamic vs static narrowphase for the dense dynamics in range, writing
+    /// contacts to the chunk's buffer. Ranges can run on different threads.
+    /// </summary>
+    void find_static_contacts(const JobRange& range);
+
+    /// <summary>
+    /// Catches bodies in range whose move this step took them through a
+    /// static, stopping them against it. Only writes to those bodies, so ranges
+    /// can run on different threads.
+    /// </summary>
+    void stop_static_tunneling(const JobRange& range);
+
+    DynamicObjectRef get_dynamic_at(size_t index);
+
+    /// <summary>
+    /// Removes a live dynamic from the dense storage, keeping the awake range
+    /// and previous_positions in step. Doesn't touch the broadphase.
+    /// </summary>
+    void remove_dynamic_storage(DynamicID id);
+
+    /// <summary>
+    /// Swaps two dense dynamics along with their previous positions.
+    /// </summary>
+    void swap_dynamics(size_t a, size_t b);
+
+    /// <summary>
+    /// Moves every body of a sleeping island back into the awake range.
+    /// </summary>
+    void wake_island(uint32_t island);
+
+    /// <summary>
+    /// Counts how long each awake body has been still, groups awake bodies
+    /// into islands through this step's contacts, and puts to sleep every
+    /// island whose bodies have all been still for SLEEP_TICKS.
+    /// </summary>
+    void update_sleep(float delta_time);
+
+    /// <summary>
+    /// Throws unless every object can go into the grid: a unit box on a cell
+    /// centre, in a cell not already taken by a static in the grid or by
+    /// another one of the objects.
+    /// </summary>
+    void validate_voxel_statics(const VoxelGrid& grid, std::span<const StaticObject> objects, const char* caller) const;
+
     public:
+    /// <param name="job_system">: pool to run step() on. Creates its own using every core when null.</param>
+    PhysicsSystem(std::shared_ptr<JobSystem> job_system = nullptr);
+
+    /// <summary>
+    /// Replaces the job system with a new one running this many threads (0 = every core).
+    /// </summary>
+    void set_thread_count(size_t thread_count);
+
+    /// <summary>
+    /// When enabled, step() gives the same results regardless of thread count.
+    /// </summary>
+    void set_deterministic(bool enabled);
+
     StaticObject& get_static(StaticID id);
         
-    DynamicObject& get_dynamic(DynamicID id);
+    DynamicObjectRef get_dynamic(DynamicID id);
 
-    StaticID add_static(const glm::vec3& pos);
+    /// <summary>
+    /// Throws if the half extents don't make a valid shape of the type, see ShapeType.
+    /// </summary>
+    StaticID add_static(const glm::vec3& pos, ShapeType shape = ShapeType::aabb,
+                        const glm::vec3& half_extents = glm::vec3(OBJECT_HALF_WIDTH));
 
-    DynamicID add_dynamic(const glm::vec3& pos, const glm::vec3& vel, const glm::vec3& f, float m);
+    /// <summary>
+    /// Throws if m <= 0.0f, or if the half extents don't make a valid shape of the type.
+    /// </summary>
+    DynamicID add_dynamic(const glm::vec3& pos, const glm::vec3& vel, const glm::vec3& f, float m, ShapeType shape = ShapeType::aabb,
+                          const glm::vec3& half_extents = glm::vec3(OBJECT_HALF_WIDTH));
 
     void remove_static(StaticID id);
 
     void remove_dynamic(DynamicID id);
 
-    const glm::vec3 get_overlap(const glm::vec3& pos1, const glm::vec3 pos2, float half_width) const;
+    /// <summary>
+    /// Adds every static in one pass. With the BVH broadphase the tree is
+    /// rebuilt once at the end instead of growing it one insert at a time.
+    /// Throws before adding anything if any shape is invalid.
+    /// </summary>
+    /// <param name="ids">: the new objects' ids are appended, in the same order</param>
+    void add_statics(std::span<const StaticObject> objects, std::vector<StaticID>& ids);
+
+    /// <summary>
+    /// add_statics() with a BVH already built over the objects (e.g. one kept in
+    /// a level file) copied in rather than built. Leaf handles in bvh_nodes are
+    /// indices into objects. Only used with the BVH broadphase and no statics
+    /// added yet, otherwise the objects go through add_statics() and the tree is
+    /// ignored. Throws before adding anything if the tree or any shape is invalid.
+    /// </summary>
+    /// <param name="ids">: the new objects' ids are appended, in the same order</param>
+    void add_statics(std::span<const StaticObject> objects, std::span<const BVHNode> bvh_nodes, int32_t bvh_root,
+                     std::vector<StaticID>& ids);
+
+    /// <summary>
+    /// Adds every dynamic in one pass. Throws before adding anything if any
+    /// mass is <= 0.0f or any shape is invalid.
+    /// </summary>
+    /// <param name="ids">: the new objects' ids are appended, in the same order</param>
+    void add_dynamics(std::span<const DynamicObject> objects, std::vector<DynamicID>& ids);
+
+    /// <summary>
+    /// Removes every given dynamic in one pass. Throws before removing anything
+    /// if any id doesn't refer to an existing dynamic object or is given twice.
+    /// </summary>
+    void remove_dynamics(std::span<const DynamicID> ids);
+
+    /// <summary>
+    /// Adds to the force applied on the next step, waking the body (and its
+    /// island) if it was asleep. Writes made through get_dynamic() don't wake
+    /// a sleeping body, so forces and velocities should go through here or be
+    /// followed by wake().
+    /// </summary>
+    void apply_force(DynamicID id, const glm::vec3& force);
+
+    void wake(DynamicID id);
+
+    bool is_sleeping(DynamicID id);
+
+    size_t get_awake_count() const;
 
-    const bool are_colliding(phys::DynamicObject& a, phys::StaticObject b) const;
+    /// <summary>
+    /// Turning sleeping off wakes everything and keeps every body simulated.
+    /// </summary>
+    void set_sleeping(bool enabled);
+
+    /// <summary>
+    /// Passes the contact solver makes over every contact each step. More
+    /// settles tall stacks faster, warm starting keeps 4 to 8 enough for most.
+    /// </summary>
+    void set_solver_iterations(uint32_t iterations);
+
+    /// <summary>
+    /// Fraction of the approach speed contacts bounce back with, in [0, 1].
+    /// </summary>
+    void set_restitution(float restitution);
+
+    /// <summary>
+    /// Switches which structure step() uses to find statics near a body, and
+    /// builds it from the statics that already exist. The voxel grid throws if
+    /// any static isn't a unit box on a cell centre, or shares a cell with another.
+    /// </summary>
+    /// <param name="voxel_offset">: voxel grid only, cell centres are at voxel_offset + integer coordinates</param>
+    void set_static_broadphase(StaticBroadphase type, const glm::vec3& voxel_offset = glm::vec3(0.0f));
+
+    /// <summary>
+    /// Bulk builds the static broadphase from scratch. Call after adding a lot of
+    /// statics at once (e.g. loading a level), since one by one inserts leave a
+    /// less tidy tree than a bulk build does.
+    /// </summary>
+    void rebuild_static_broadphase();
+
+    /// <summary>
+    /// Finds every static whose box touches the given box.
+    /// </summary>
+    /// <param name="out">: cleared, then filled with the StaticID of each candidate</param>
+    void query_statics(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const;
+
+    const glm::vec3 get_overlap(const glm::vec3& pos1, const glm::vec3& half_extents1, const glm::vec3& pos2, const glm::vec3& half_extents2) const;
+
+    const bool are_colliding(const phys::DynamicObjectRef& a, phys::StaticObject b) const;
+
+    const bool are_colliding(const phys::DynamicObjectRef& a, const phys::DynamicObjectRef& b) const;
+
+    /// <summary>
+    /// Swept box test of a dynamic object moving from one position to another
+    /// against a static. Only reports the static being entered during the move,
+    /// not one the object already overlapped at the start. Round shapes are
+    /// swept as their bounding boxes.
+    /// </summary>
+    /// <param name="time_of_impact">: fraction of the move, in [0, 1], at which the boxes first touch</param>
+    /// <param name="axis">: axis of the face that was hit, 0 = x, 1 = y, 2 = z</param>
+    /// <returns>true if the boxes touch somewhere along the move</returns>
+    bool sweep_against_static(const glm::vec3& from, const glm::vec3& to, const glm::vec3& half_extents,
+                              const glm::vec3& static_position, const glm::vec3& static_half_extents,
+                              float& time_of_impact, int& axis) const;
 
     void step(float delta_time);
 
+    /// <summary>
+    /// Every contact resolved during the last step(), dynamic vs dynamic pairs
+    /// first and then dynamic vs static. Only valid until the next step().
+    /// </summary>
+    std::span<const CollisionEvent> get_collision_events() const;
+
+    /// <summary>
+    /// Copies the current and pre-step position of every dynamic object into
+    /// the snapshot, at the handle_index() of its DynamicID, reusing its
+    /// storage. Before the first step, and while asleep, both are the current
+    /// position. tick and time are left to the caller.
+    /// </summary>
+    void write_snapshot(PhysicsSnapshot& snapshot) const;
+
+    /// <summary>
+    /// Saves the whole simulation state into out, replacing what it held and
+    /// reusing its buffer: every object and handle slot, which bodies sleep,
+    /// the dynamic broadphase's order and the solver's cached impulses.
+    /// Settings (threads, determinism, solver iterations, restitution) are not
+    /// part of it. Ordered so what rarely changes comes first, which keeps
+    /// deltas small, see make_snapshot_delta().
+    /// </summary>
+    void snapshot(WorldSnapshot& out) const;
+
+    /// <summary>
+    /// Puts the simulation back as snapshot() saved it, so stepping on from
+    /// here repeats what stepping on from there did, given the same settings.
+    /// Ids are restored too, ones handed out since refer to nothing (or to
+    /// something else) again. The static broadphase is only rebuilt if the
+    /// statics or the broadphase differ from the current ones, so rolling
+    /// back a world whose level never changes costs no rebuild. The whole
+    /// snapshot is loaded and checked on the side before any of it replaces
+    /// the world, so one that is malformed or from another version throws and
+    /// leaves the world as it was. That side copy is kept for the next restore,
+    /// so restoring takes as much memory again as the state restored.
+    /// </summary>
+    void restore(const WorldSnapshot& snapshot);
+
+    /// <summary>
+    /// Logs the position and velocity of every dynamic object at debug level.
+    /// </summary>
     void debug_objects();
 };
 
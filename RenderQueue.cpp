@@ -0,0 +1,61 @@
+#include "RenderQueue.hpp"
+
+uint64_t gfx::RenderQueue::make_key(uint32_t shader, uint32_t mesh, float depth)
+{
+    // Non-negative IEEE floats order the same as their bit patterns.
+    uint32_t depth_bits = 0;
+    if (depth > 0.0f)
+    {
+        std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+    }
+    return (uint64_t(shader & 0xFFFF) << 48) | (uint64_t(mesh & 0xFFFF) << 32) | depth_bits;
+}
+
+void gfx::RenderQueue::clear()
+{
+    items.clear();
+}
+
+void gfx::RenderQueue::push(uint64_t key, uint32_t payload)
+{
+    items.push_back({ key, payload });
+}
+
+void gfx::RenderQueue::sort()
+{
+    scratch.resize(items.size());
+
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {};
+        for (const RenderItem& item : items)
+        {
+            counts[(item.key >> shift) & 0xFF]++;
+        }
+
+        // Everything would land in one bucket, so this pass wouldn't move anything.
+        if (counts[(items.empty() ? 0 : items[0].key >> shift) & 0xFF] == items.size())
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t& count : counts)
+        {
+            size_t bucket_size = count;
+            count = offset;
+            offset += bucket_size;
+        }
+
+        for (const RenderItem& item : items)
+        {
+            scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+        }
+        items.swap(scratch);
+    }
+}
+
+std::span<const gfx::RenderItem> gfx::RenderQueue::get_items() const
+{
+    return items;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <span>
+
+namespace gfx
+{
+
+struct RenderItem
+{
+    uint64_t key;
+    uint32_t payload; // caller's index for whatever it needs to draw this item
+};
+
+/// <summary>
+/// Per frame list of draws, sorted by a packed key so identical GPU state ends
+/// up adjacent. Keys are laid out (high to low) as 16 bits shader, 16 bits mesh,
+/// 32 bits depth, so draws group by program first, then by VAO, and go front to
+/// back inside a group.
+/// </summary>
+class RenderQueue
+{
+  private:
+    std::vector<RenderItem> items{};
+    std::vector<RenderItem> scratch{}; // ping-pong buffer for the radix passes
+
+  public:
+    /// <summary>
+    /// Only the low 16 bits of shader and mesh are kept, so two different ones
+    /// can share a key. Sorting is then slightly less effective, but callers
+    /// that compare the real ids when walking the queue still draw correctly.
+    /// Negative depths (behind the camera) sort as 0.
+    /// </summary>
+    static uint64_t make_key(uint32_t shader, uint32_t mesh, float depth);
+
+    void clear();
+
+    void push(uint64_t key, uint32_t payload);
+
+    /// <summary>
+    /// LSD radix sort, 8 bits per pass. Passes where every key has the same
+    /// byte are skipped, which is most of the shader/mesh bytes in practice.
+    /// Stable, so equal keys keep their push order.
+    /// </summary>
+    void sort();
+
+    std::span<const RenderItem> get_items() const;
+};
+
+}
\ No newline at end of file
@@ -3,10 +3,12 @@
 gfx::RenderingSystem::RenderingSystem
 (
     std::shared_ptr<MeshRegistry>        mesh_registry,
+    std::shared_ptr<ShaderSystem>        shader_system,
     std::shared_ptr<phys::PhysicsSystem> physics_system
 )
     :
     mesh_registry(std::move(mesh_registry)),
+    shader_system(std::move(shader_system)),
     physics_system(std::move(physics_system))
 {
 }
@@ -14,13 +16,26 @@ gfx::RenderingSystem::RenderingSystem
 gfx::RenderableID gfx::RenderingSystem::new_renderable(const Renderable& renderable)
 {
     RenderableID id = RenderableID(renderables.add(renderable));
+    statics_dirty = statics_dirty or std::holds_alternative<phys::StaticID>(renderable.physics_id);
     return id;
 }
 
+void gfx::RenderingSystem::new_renderables(MeshID mesh_id, std::span<const phys::StaticID> static_ids, std::vector<RenderableID>& ids)
+{
+    renderables.reserve(renderables.get_dense().size() + static_ids.size());
+    ids.reserve(ids.size() + static_ids.size());
+    for (phys::StaticID static_id : static_ids)
+    {
+        ids.push_back(RenderableID(renderables.add({ mesh_id, static_id })));
+    }
+    statics_dirty = statics_dirty or not static_ids.empty();
+}
+
 void gfx::RenderingSystem::remove_renderable(RenderableID id)
 {
     if (renderables.has(id))
     {
+        statics_dirty = statics_dirty or std::holds_alternative<phys::StaticID>(renderables.get(id).physics_id);
         renderables.remove(id);
     }
     else
@@ -33,7 +48,9 @@ gfx::Renderable& gfx::RenderingSystem::get_renderable(RenderableID id)
 {
     if (renderables.has(id))
     {
-        return renderables.get(id);
+        Renderable& renderable = renderables.get(id);
+        statics_dirty = statics_dirty or std::holds_alternative<phys::StaticID>(renderable.physics_id);
+        return renderable;
     }
     else
     {
@@ -41,37 +58,207 @@ gfx::Renderable& gfx::RenderingSystem::get_renderable(RenderableID id)
     }
 }
 
-void gfx::RenderingSystem::render()
+void gfx::RenderingSystem::set_model_matrix(const glm::mat4& matrix)
+{
+    model_matrix = matrix;
+    matrices_version++;
+}
+
+void gfx::RenderingSystem::set_projection_matrix(const glm::mat4& matrix)
+{
+    projection_matrix = matrix;
+    matrices_version++;
+}
+
+void gfx::RenderingSystem::rebuild_static_instances()
 {
+    render_queue.clear();
+    frame_draws.clear();
     for (Renderable& renderable : renderables.get_dense())
     {
-        glm::mat4 view_matrix = glm::mat4(1.0f);
+        if (std::holds_alternative<phys::StaticID>(renderable.physics_id))
+        {
+            glm::vec3 position = physics_system->get_static(std::get<phys::StaticID>(renderable.physics_id)).position;
+            Mesh&     mesh     = mesh_registry->get_mesh(renderable.mesh_id);
+            render_queue.push(RenderQueue::make_key(mesh.shader, renderable.mesh_id, 0.0f), (uint32_t)frame_draws.size());
+            frame_draws.push_back({ position, renderable.mesh_id, mesh.shader, mesh.vao });
+        }
+    }
+    render_queue.sort();
+    std::span<const RenderItem> items = render_queue.get_items();
+
+    std::vector<glm::vec3> translations(items.size());
+    static_runs.clear();
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        const FrameDraw& draw = frame_draws[items[i].payload];
+        translations[i] = draw.translation;
+
+        // Compare the real ids, the key only holds the low bits of each.
+        if (static_runs.empty() or static_runs.back().shader != draw.shader or static_runs.back().mesh_id != draw.mesh_id)
+        {
+            static_runs.push_back({ draw.shader, draw.mesh_id, draw.vao, i, 0 });
+        }
+        static_runs.back().count++;
+    }
+
+    if (static_instances == 0)
+    {
+        glGenBuffers(1, &static_instances);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, static_instances);
+    glBufferData(GL_ARRAY_BUFFER, translations.size() * sizeof(glm::vec3), translations.data(), GL_STATIC_DRAW);
+
+    static_count  = items.size();
+    statics_dirty = false;
+}
+
+void gfx::RenderingSystem::draw_instances(uint32_t shader, uint32_t vao, size_t byte_offset, size_t count)
+{
+    if (shader != bound_shader)
+    {
+        glUseProgram(shader);
+        bound_shader = shader;
+        stats.program_binds++;
 
+        uint64_t& uploaded_version = uploaded_versions[shader];
+        if (uploaded_version != matrices_version)
+        {
+            const ShaderProgram& program = shader_system->get_program(shader);
+            glUniformMatrix4fv(program.model_location, 1, GL_FALSE, glm::value_ptr(model_matrix));
+            glUniformMatrix4fv(program.view_location, 1, GL_FALSE, glm::value_ptr(view_matrix));
+            glUniformMatrix4fv(program.projection_location, 1, GL_FALSE, glm::value_ptr(projection_matrix));
+            uploaded_version = matrices_version;
+        }
+    }
+
+    if (vao != bound_vao)
+    {
+        glBindVertexArray(vao);
+        bound_vao = vao;
+        stats.vao_binds++;
+
+        if (prepared_vaos.insert(vao).second)
+        {
+            glEnableVertexAttribArray(INSTANCE_OFFSET_LOCATION);
+            glVertexAttribDivisor(INSTANCE_OFFSET_LOCATION, 1);
+        }
+    }
+
+    // per-instance translation attr, pointed at this run's slice of the bound buffer
+    glVertexAttribPointer(INSTANCE_OFFSET_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)byte_offset);
+    glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, (GLsizei)count);
+    stats.draw_calls++;
+}
+
+void gfx::RenderingSystem::render(const phys::PhysicsSnapshot* snapshot, float alpha)
+{
+    if (statics_dirty)
+    {
+        rebuild_static_instances();
+    }
+
+    render_queue.clear();
+    frame_draws.clear();
+
+    for (Renderable& renderable : renderables.get_dense())
+    {
         if (std::holds_alternative<phys::StaticID>(renderable.physics_id))
         {
-            glm::vec3& position = physics_system->get_static(std::get<phys::StaticID>(renderable.physics_id)).position;
-            view_matrix = glm::translate(view_matrix, position);
+            continue;
+        }
+
+        glm::vec3 position;
+        if (snapshot == nullptr)
+        {
+            position = physics_system->get_dynamic(std::get<phys::DynamicID>(renderable.physics_id)).position;
         }
         else
         {
-            glm::vec3& position = physics_system->get_dynamic(std::get<phys::DynamicID>(renderable.physics_id)).position;
-            view_matrix = glm::translate(view_matrix, position);
+            uint32_t index = handle_index(std::get<phys::DynamicID>(renderable.physics_id));
+            if (index >= snapshot->positions.size())
+            {
+                continue; // added after the snapshot was taken
+            }
+            const glm::vec3& previous = snapshot->previous_positions[index];
+            position = previous + (snapshot->positions[index] - previous) * alpha;
         }
 
-        Mesh& mesh = mesh_registry->get_mesh(renderable.mesh_id);
+        Mesh& mesh  = mesh_registry->get_mesh(renderable.mesh_id);
+        float depth = -(view_matrix * glm::vec4(position, 1.0f)).z;
 
-        uint32_t model_location = glGetUniformLocation(mesh.shader, "model");
-        glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(model_matrix));
+        render_queue.push(RenderQueue::make_key(mesh.shader, renderable.mesh_id, depth), (uint32_t)frame_draws.size());
+        frame_draws.push_back({ position, renderable.mesh_id, mesh.shader, mesh.vao });
+    }
 
-        uint32_t view_location = glGetUniformLocation(mesh.shader, "view");
-        glUniformMatrix4fv(view_location, 1, GL_FALSE, glm::value_ptr(view_matrix));
+    render_queue.sort();
+    std::span<const RenderItem> items = render_queue.get_items();
 
-        uint32_t projection_location = glGetUniformLocation(mesh.shader, "projection");
-        glUniformMatrix4fv(projection_location, 1, GL_FALSE, glm::value_ptr(projection_matrix));
+    stats = RenderStats{};
+    stats.renderables = items.size() + static_count;
+    bound_shader      = 0;
+    bound_vao         = 0;
 
-        glUseProgram(mesh.shader);
-        glBindVertexArray(mesh.vao);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    if (not items.empty())
+    {
+        // The translations are gathered rather than copied out of the physics
+        // system's dense arrays in one go: draws are grouped by shader and mesh,
+        // which dense order knows nothing about, bodies without a renderable
+        // have no place in the stream, and snapshot positions are interpolated
+        // first. The gather writes each translation straight into the mapped
+        // stream buffer, so it is still the only copy made on the CPU.
+        glm::vec3* translations = transforms.begin_frame(items.size());
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            translations[i] = frame_draws[items[i].payload].translation;
+        }
+        transforms.finish_writes();
+        size_t frame_offset = transforms.get_frame_offset();
+
+        size_t run_begin = 0;
+        while (run_begin < items.size())
+        {
+            // Compare the real ids, the key only holds the low bits of each.
+            const FrameDraw& first = frame_draws[items[run_begin].payload];
+            size_t run_end = run_begin + 1;
+            while (run_end < items.size())
+            {
+                const FrameDraw& next = frame_draws[items[run_end].payload];
+                if (next.shader != first.shader or next.mesh_id != first.mesh_id)
+                {
+                    break;
+                }
+                run_end++;
+            }
+
+            draw_instances(first.shader, first.vao, frame_offset + run_begin * sizeof(glm::vec3), run_end - run_begin);
+            run_begin = run_end;
+        }
     }
+
+    if (not static_runs.empty())
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, static_instances);
+        for (const StaticRun& run : static_runs)
+        {
+            draw_instances(run.shader, run.vao, run.first * sizeof(glm::vec3), run.count);
+        }
+    }
+
+    glBindVertexArray(0);
+    if (not items.empty())
+    {
+        transforms.end_frame();
+    }
+
+    size_t unsorted_changes = stats.renderables * 3;
+    size_t sorted_changes   = stats.program_binds + stats.vao_binds + 1;
+    stats.state_changes_saved = unsorted_changes > sorted_changes ? unsorted_changes - sorted_changes : 0;
+
+    PHYS_LOG_TRACE("render: {} renderables, {} draws, {} state changes saved", stats.renderables, stats.draw_calls, stats.state_changes_saved);
 }
+
+const gfx::RenderStats& gfx::RenderingSystem::get_render_stats() const
+{
+    return stats;
+}
\ No newline at end of file
@@ -1,10 +1,18 @@
 #pragma once
 #include "MeshRegistry.hpp"
+#include "RenderQueue.hpp"
+#include "TransformStream.hpp"
+#include "ShaderSystem.hpp"
 #include "SparseSet.hpp"
 #include "PhysicsSystem.hpp"
 
+#include <algorithm>
 #include <variant>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <span>
 #include <stdexcept>
 
 #include <glad/glad.h>
@@ -30,26 +38,119 @@ struct Renderable
     std::variant<phys::StaticID, phys::DynamicID> physics_id;
 };
 
+constexpr uint32_t INSTANCE_OFFSET_LOCATION = 2; // vertex attribute carrying each instance's translation
+
+/// <summary>
+/// What the last render() did. state_changes_saved compares against drawing every
+/// renderable on its own, which costs a program bind, a VAO bind and a VAO unbind each.
+/// </summary>
+struct RenderStats
+{
+    size_t renderables         = 0;
+    size_t draw_calls          = 0;
+    size_t program_binds       = 0;
+    size_t vao_binds           = 0;
+    size_t state_changes_saved = 0;
+};
+
 class RenderingSystem
 {
   private:
     std::shared_ptr<MeshRegistry>        mesh_registry;
+    std::shared_ptr<ShaderSystem>        shader_system;
     std::shared_ptr<phys::PhysicsSystem> physics_system;
     SparseSet<Renderable>                renderables;
 
+    // Per frame scratch, kept between frames so nothing reallocates once the scene has settled.
+    struct FrameDraw
+    {
+        glm::vec3 translation;
+        uint32_t  mesh_id;
+        uint32_t  shader;
+        uint32_t  vao;
+    };
+    RenderQueue            render_queue;
+    std::vector<FrameDraw> frame_draws;        // indexed by RenderItem::payload
+    TransformStream        transforms;         // dynamic translations in sorted order, streamed as one block
+    std::unordered_set<uint32_t> prepared_vaos; // VAOs that already have the instance attribute enabled
+
+    // Statics never move, so their translations sit in a buffer of their own,
+    // grouped by shader and mesh, that is only rebuilt when a static renderable
+    // is added or removed.
+    struct StaticRun
+    {
+        uint32_t shader;
+        uint32_t mesh_id;
+        uint32_t vao;
+        size_t   first; // instance index into static_instances
+        size_t   count;
+    };
+    uint32_t               static_instances = 0;
+    size_t                 static_count     = 0;
+    std::vector<StaticRun> static_runs;
+    bool                   statics_dirty    = true;
+
+    uint32_t bound_shader = 0; // as of the last draw, reset every frame
+    uint32_t bound_vao    = 0;
+
+    RenderStats stats;
+
     glm::mat4 model_matrix      = glm::mat4(1.0f);
     glm::mat4 projection_matrix = glm::perspective(glm::radians(72.0f), (float)1600 / (float)900, 0.1f, 100.0f);
+    glm::mat4 view_matrix       = glm::mat4(1.0f); // translations are applied per instance, see INSTANCE_OFFSET_LOCATION
+
+    // Uniform values live in each program, so matrices are only uploaded to a
+    // program when they changed since it last saw them.
+    uint64_t                               matrices_version = 1;
+    std::unordered_map<uint32_t, uint64_t> uploaded_versions; // program id -> matrices_version it holds
+
+    void rebuild_static_instances();
+
+    /// <summary>
+    /// Binds shader and vao unless they already are, then draws count instances
+    /// whose translations start at byte_offset in the buffer bound to GL_ARRAY_BUFFER.
+    /// </summary>
+    void draw_instances(uint32_t shader, uint32_t vao, size_t byte_offset, size_t count);
 
   public:
-    RenderingSystem(std::shared_ptr<MeshRegistry> mesh_registry, std::shared_ptr<phys::PhysicsSystem> physics_system);
+    RenderingSystem
+    (
+        std::shared_ptr<MeshRegistry>        mesh_registry,
+        std::shared_ptr<ShaderSystem>        shader_system,
+        std::shared_ptr<phys::PhysicsSystem> physics_system
+    );
 
     RenderableID new_renderable(const Renderable& renderable);
 
+    /// <summary>
+    /// One renderable per static, all drawn with the same mesh, added in one pass.
+    /// </summary>
+    /// <param name="ids">: the new renderables' ids are appended, in the same order</param>
+    void new_renderables(MeshID mesh_id, std::span<const phys::StaticID> static_ids, std::vector<RenderableID>& ids);
+
     void remove_renderable(RenderableID id);
     
+    /// <summary>
+    /// Getting a static renderable rebuilds the static instances on the next
+    /// render(), in case it is changed through the reference.
+    /// </summary>
     Renderable& get_renderable(RenderableID id);
 
-    void render();
+    void set_model_matrix(const glm::mat4& matrix);
+
+    void set_projection_matrix(const glm::mat4& matrix);
+
+    /// <summary>
+    /// Sorts every dynamic renderable through the render queue, then draws each
+    /// run of identical shader and mesh with one glDrawElementsInstanced, followed
+    /// by one draw per run of statics.
+    /// </summary>
+    /// <param name="snapshot">: if given, dynamic positions come from it instead of the live
+    /// PhysicsSystem, so rendering can overlap a step running on another thread</param>
+    /// <param name="alpha">: how far to interpolate from the snapshot's previous positions (0) to its current ones (1)</param>
+    void render(const phys::PhysicsSnapshot* snapshot = nullptr, float alpha = 1.0f);
+
+    const RenderStats& get_render_stats() const;
 
 };
 
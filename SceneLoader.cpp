@@ -0,0 +1,90 @@
+#include "SceneLoader.hpp"
+
+bool phys::read_shape(std::istringstream& stream, ShapeType& shape, glm::vec3& half_extents)
+{
+    std::string name;
+    if (not (stream >> name))
+    {
+        return true;
+    }
+
+    if (name == "aabb")
+    {
+        shape = ShapeType::aabb;
+    }
+    else if (name == "sphere")
+    {
+        shape = ShapeType::sphere;
+    }
+    else if (name == "capsule")
+    {
+        shape = ShapeType::capsule;
+    }
+    else
+    {
+        return false;
+    }
+    return static_cast<bool>(stream >> half_extents.x >> half_extents.y >> half_extents.z);
+}
+
+phys::SceneStats phys::load_scene(const char* filepath, PhysicsSystem& physics_system)
+{
+    std::ifstream file(filepath);
+    if (not file)
+    {
+        throw std::runtime_error(std::format("phys::load_scene() failed. Could not open {}", filepath));
+    }
+
+    std::vector<StaticObject>  statics;
+    std::vector<DynamicObject> dynamics;
+    std::string                line;
+    size_t                     line_number = 0;
+
+    while (std::getline(file, line))
+    {
+        line_number++;
+
+        std::istringstream stream(line);
+        std::string kind;
+        if (not (stream >> kind) or kind[0] == '#')
+        {
+            continue;
+        }
+
+        if (kind == "static")
+        {
+            StaticObject object = {};
+            glm::vec3&   pos    = object.position;
+            if (stream >> pos.x >> pos.y >> pos.z and read_shape(stream, object.shape, object.half_extents))
+            {
+                statics.push_back(object);
+                continue;
+            }
+        }
+        else if (kind == "dynamic")
+        {
+            DynamicObject object = {};
+            glm::vec3& pos = object.position;
+            glm::vec3& vel = object.velocity;
+            glm::vec3& f   = object.force;
+            float&     m   = object.mass;
+            if (stream >> pos.x >> pos.y >> pos.z >> vel.x >> vel.y >> vel.z >> f.x >> f.y >> f.z >> m
+                and read_shape(stream, object.shape, object.half_extents))
+            {
+                dynamics.push_back(object);
+                continue;
+            }
+        }
+
+        throw std::runtime_error(std::format("phys::load_scene() failed. {} line {} is not a valid object: {}",
+                                             filepath, line_number, line));
+    }
+
+    // Added all at once so a big level is a couple of passes, not one call per line.
+    std::vector<StaticID>  static_ids;
+    std::vector<DynamicID> dynamic_ids;
+    physics_system.add_statics(statics, static_ids);
+    physics_system.add_dynamics(dynamics, dynamic_ids);
+
+    return { statics.size(), dynamics.size() };
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "PhysicsSystem.hpp"
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <format>
+
+namespace phys
+{
+
+struct SceneStats
+{
+    size_t static_count;
+    size_t dynamic_count;
+};
+
+/// <summary>
+/// Reads the optional shape at the end of a line, "shape hx hy hz". Leaves
+/// shape and half_extents alone when there is none, returns false when there
+/// is one but it doesn't parse.
+/// </summary>
+bool read_shape(std::istringstream& stream, ShapeType& shape, glm::vec3& half_extents);
+
+/// <summary>
+/// Adds the objects described in a text scene file to the physics system. One
+/// object per line, blank lines and lines starting with '#' are skipped:
+///   static  x y z                           [shape hx hy hz]
+///   dynamic x y z  vx vy vz  fx fy fz  mass [shape hx hy hz]
+/// shape is aabb, sphere or capsule, followed by its half extents (see
+/// ShapeType). Objects without one are unit boxes.
+/// </summary>
+/// <param name="filepath">: path to the scene file</param>
+/// <param name="physics_system">: system to add the objects to</param>
+SceneStats load_scene(const char* filepath, PhysicsSystem& physics_system);
+
+}
@@ -37,7 +37,7 @@ uint32_t gfx::ShaderSystem::compile_shader(const char* shader_str, int shader_ty
     return shader_id;
 }
 
-uint32_t gfx::ShaderSystem::create_shader_program(const char* vertex_shader_source, const char* fragment_shader_source)
+const gfx::ShaderProgram& gfx::ShaderSystem::create_shader_program(const char* vertex_shader_source, const char* fragment_shader_source)
 {
     std::string  vertex_shader_str = read_file(vertex_shader_source);
     std::string  fragment_shader_str = read_file(fragment_shader_source);
@@ -62,5 +62,77 @@ uint32_t gfx::ShaderSystem::create_shader_program(const char* vertex_shader_sour
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 
-    return shader_program;
+    ShaderProgram& program = programs[shader_program];
+    program.id = shader_program;
+    reflect_program(program);
+
+    return program;
+}
+
+void gfx::ShaderSystem::reflect_program(ShaderProgram& program)
+{
+    int max_name_length = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+    int max_attribute_length = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_attribute_length);
+    std::string name(std::max(max_name_length, max_attribute_length) + 1, '\0');
+
+    int uniform_count = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &uniform_count);
+    for (int i = 0; i < uniform_count; i++)
+    {
+        GLsizei length = 0;
+        GLint   count  = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(program.id, i, (GLsizei)name.size(), &length, &count, &type, name.data());
+
+        std::string uniform_name(name.data(), length);
+        int32_t     location = glGetUniformLocation(program.id, uniform_name.c_str());
+        if (uniform_name.ends_with("[0]"))
+        {
+            uniform_name.resize(uniform_name.size() - 3);
+        }
+        program.uniforms[uniform_name] = { location, type, count };
+    }
+
+    int attribute_count = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_ATTRIBUTES, &attribute_count);
+    for (int i = 0; i < attribute_count; i++)
+    {
+        GLsizei length = 0;
+        GLint   count  = 0;
+        GLenum  type   = 0;
+        glGetActiveAttrib(program.id, i, (GLsizei)name.size(), &length, &count, &type, name.data());
+
+        std::string attribute_name(name.data(), length);
+        int32_t     location = glGetAttribLocation(program.id, attribute_name.c_str());
+        program.attributes[attribute_name] = { location, type, count };
+    }
+
+    program.model_location      = program.get_uniform_location("model");
+    program.view_location       = program.get_uniform_location("view");
+    program.projection_location = program.get_uniform_location("projection");
+}
+
+const gfx::ShaderProgram& gfx::ShaderSystem::get_program(uint32_t id) const
+{
+    auto found = programs.find(id);
+    if (found != programs.end())
+    {
+        return found->second;
+    }
+    else
+    {
+        throw std::runtime_error("gfx::ShaderSystem::get_program() failed. No program with this id was created by this ShaderSystem!");
+    }
+}
+
+int32_t gfx::ShaderProgram::get_uniform_location(const std::string& name) const
+{
+    auto found = uniforms.find(name);
+    if (found != uniforms.end())
+    {
+        return found->second.location;
+    }
+    return -1;
 }
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <stdexcept>
 #include <vector>
 #include <format>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 #include <glad/glad.h>
@@ -17,13 +21,55 @@ namespace gfx
 
 std::string read_file(const char* filepath);
 
+/// <summary>
+/// An active uniform or vertex attribute, as reported by the driver at link time.
+/// </summary>
+struct ShaderVariable
+{
+    int32_t  location;
+    uint32_t type;  // GL_FLOAT_MAT4, GL_FLOAT_VEC3, ...
+    int32_t  count; // array length, 1 for non-arrays
+};
+
+/// <summary>
+/// A linked program and everything reflected from it. Locations of the uniforms
+/// the renderer sets every frame are pulled out so drawing never looks a name
+/// up; they are -1 when the program doesn't use them, which GL ignores.
+/// </summary>
+struct ShaderProgram
+{
+    uint32_t id;
+    std::unordered_map<std::string, ShaderVariable> uniforms;   // array uniforms are keyed without the "[0]"
+    std::unordered_map<std::string, ShaderVariable> attributes;
+
+    int32_t model_location      = -1;
+    int32_t view_location       = -1;
+    int32_t projection_location = -1;
+
+    /// <summary>
+    /// Looks a uniform up by name, returning -1 if the program has no such active uniform.
+    /// Meant for setup code, not per-frame use.
+    /// </summary>
+    int32_t get_uniform_location(const std::string& name) const;
+};
+
 class ShaderSystem
 {
   private:
+    std::unordered_map<uint32_t, ShaderProgram> programs; // program id -> reflection, references stay valid
+
     uint32_t compile_shader(const char* shader_str, int shader_type);
 
+    void reflect_program(ShaderProgram& program);
+
   public:
-    uint32_t create_shader_program(const char* vertex_shader_source, const char* fragment_shader_source);
+    /// <summary>
+    /// Compiles and links the two shader files and reflects the result's active
+    /// uniforms and attributes.
+    /// </summary>
+    const ShaderProgram& create_shader_program(const char* vertex_shader_source, const char* fragment_shader_source);
+
+    const ShaderProgram& get_program(uint32_t id) const;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// Appends raw bytes to a flat buffer. Everything written must be trivially
+/// copyable, so saving state is one memcpy per array.
+/// </summary>
+class SnapshotWriter
+{
+  private:
+    std::vector<std::byte>& bytes;
+
+  public:
+    /// <param name="bytes">: appended to, its capacity is reused so steady state saves don't allocate</param>
+    explicit SnapshotWriter(std::vector<std::byte>& bytes) : bytes(bytes) {}
+
+    void write(const void* data, size_t size)
+    {
+        const std::byte* first = static_cast<const std::byte*>(data);
+        bytes.insert(bytes.end(), first, first + size);
+    }
+
+    template<typename T>
+    void write_value(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&value, sizeof(T));
+    }
+
+    /// <summary>
+    /// The element count followed by the elements.
+    /// </summary>
+    template<typename Vector>
+    void write_vector(const Vector& vector)
+    {
+        static_assert(std::is_trivially_copyable_v<typename Vector::value_type>);
+        write_value<uint64_t>(vector.size());
+        write(vector.data(), vector.size() * sizeof(typename Vector::value_type));
+    }
+};
+
+/// <summary>
+/// Reads back what a SnapshotWriter wrote, in the same order. Throws instead
+/// of reading past the end.
+/// </summary>
+class SnapshotReader
+{
+  private:
+    std::span<const std::byte> bytes;
+    size_t                     position = 0;
+
+  public:
+    explicit SnapshotReader(std::span<const std::byte> bytes) : bytes(bytes) {}
+
+    void read(void* data, size_t size)
+    {
+        if (size > bytes.size() - position)
+        {
+            throw std::runtime_error("SnapshotReader::read() failed. The snapshot ends early.");
+        }
+        if (size == 0)
+        {
+            return;
+        }
+        std::memcpy(data, bytes.data() + position, size);
+        position += size;
+    }
+
+    template<typename T>
+    T read_value()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+
+    /// <summary>
+    /// Replaces the vector's contents with the next vector written. Returns
+    /// false, without writing to it, if it already held exactly that.
+    /// </summary>
+    template<typename Vector>
+    bool read_vector(Vector& vector)
+    {
+        using T = typename Vector::value_type;
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        uint64_t count = read_value<uint64_t>();
+        if (count > (bytes.size() - position) / sizeof(T))
+        {
+            throw std::runtime_error("SnapshotReader::read_vector() failed. The snapshot ends early.");
+        }
+
+        size_t size = size_t(count) * sizeof(T);
+        if (vector.size() == count and (count == 0 or std::memcmp(vector.data(), bytes.data() + position, size) == 0))
+        {
+            position += size;
+            return false;
+        }
+        vector.resize(size_t(count));
+        read(vector.data(), size);
+        return true;
+    }
+
+    bool at_end() const
+    {
+        return position == bytes.size();
+    }
+
+    /// <summary>
+    /// Bytes read so far, for coming back to a section with a reader over the rest.
+    /// </summary>
+    size_t get_position() const
+    {
+        return position;
+    }
+};
\ No newline at end of file
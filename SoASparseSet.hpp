@@ -0,0 +1,283 @@
+#pragma once
+#include "SparseSet.hpp"
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/// <summary>
+/// Minimal allocator handing out memory aligned to a cache line, so each field
+/// array of a SoASparseSet starts on a fresh line and can be loaded with aligned
+/// vector instructions.
+/// </summary>
+template<typename T, size_t Alignment = 64>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* pointer, size_t)
+    {
+        ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+};
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+/// <summary>
+/// Same handle, sparse and free list behaviour as SparseSet, but every field
+/// of the stored objects is kept in its own contiguous array (structure of
+/// arrays). Loops that only touch a couple of fields then only pull those
+/// fields through the cache.
+/// </summary>
+template<typename... Fields>
+class SoASparseSet
+{
+  private:
+
+    std::tuple<AlignedVector<Fields>...> dense{};
+    std::vector<uint32_t> associated_handles{}; // for any index 'i' in dense, associated_handles stores the handle
+    PagedSparseArray      sparse{};             // associated to the object at associated_handles[i].
+
+    template<size_t... I>
+    void push_back(std::index_sequence<I...>, const Fields&... fields)
+    {
+        (std::get<I>(dense).push_back(fields), ...);
+    }
+
+    template<size_t... I>
+    std::tuple<Fields&...> at(std::index_sequence<I...>, size_t index)
+    {
+        return std::tie(std::get<I>(dense)[index]...);
+    }
+
+    template<size_t... I>
+    void swap_fields(std::index_sequence<I...>, size_t a, size_t b)
+    {
+        (std::swap(std::get<I>(dense)[a], std::get<I>(dense)[b]), ...);
+    }
+
+    template<size_t... I>
+    void swap_and_pop(std::index_sequence<I...>, size_t index)
+    {
+        ((std::get<I>(dense)[index] = std::move(std::get<I>(dense).back()), std::get<I>(dense).pop_back()), ...);
+    }
+
+  public:
+    /// <param name="size">: objects to reserve room for up front, the set grows past it as needed</param>
+    SoASparseSet(size_t size = 1000)
+    {
+        reserve(size);
+    }
+
+    void reserve(size_t count)
+    {
+        std::apply([count](auto&... field) { (field.reserve(count), ...); }, dense);
+        associated_handles.reserve(count);
+    }
+
+    uint32_t add(const Fields&... fields)
+    {
+        uint32_t index  = associated_handles.size();
+        uint32_t handle = sparse.allocate(index);
+        push_back(std::index_sequence_for<Fields...>{}, fields...);
+        associated_handles.push_back(handle);
+        return handle;
+    }
+
+    /// <summary>
+    /// References to every field of the object at this handle, in declaration order.
+    /// </summary>
+    std::tuple<Fields&...> get(uint32_t handle)
+    {
+        uint32_t index = sparse.get_dense_index(handle);
+        if (index != INVALID_HANDLE)
+        {
+            return at(std::index_sequence_for<Fields...>{}, index);
+        }
+        else
+        {
+            std::string message = std::string("SoASparseSet::Get() failed. Nothing exists at this handle, or it is stale -> ")
+                                + std::to_string(handle);
+            throw std::runtime_error(message);
+        }
+    }
+
+    void remove(uint32_t handle)
+    {
+        uint32_t index_to_delete = sparse.get_dense_index(handle);
+        if (index_to_delete != INVALID_HANDLE)
+        {
+            uint32_t last_associated_handle = associated_handles.back();
+
+            swap_and_pop(std::index_sequence_for<Fields...>{}, index_to_delete);
+            associated_handles[index_to_delete] = last_associated_handle;
+            sparse.set_dense_index(last_associated_handle, index_to_delete);
+
+            sparse.release(handle);
+
+            associated_handles.pop_back();
+        }
+        else
+        {
+            throw std::runtime_error("SoASparseSet::Delete() failed. Nothing exists at this handle, or it is stale.");
+        }
+    }
+
+    /// <summary>
+    /// Removes every object in one pass. Throws, with nothing removed, if any
+    /// handle isn't live or the same handle is given twice.
+    /// </summary>
+    void remove_batch(std::span<const uint32_t> handles)
+    {
+        std::vector<uint32_t> indices;
+        indices.reserve(handles.size());
+        for (uint32_t handle : handles)
+        {
+            uint32_t index = sparse.get_dense_index(handle);
+            if (index == INVALID_HANDLE)
+            {
+                throw std::runtime_error("SoASparseSet::DeleteBatch() failed. Nothing exists at this handle, or it is stale.");
+            }
+            indices.push_back(index);
+        }
+
+        std::sort(indices.begin(), indices.end());
+        if (std::adjacent_find(indices.begin(), indices.end()) != indices.end())
+        {
+            throw std::runtime_error("SoASparseSet::DeleteBatch() failed. The same handle is given more than once.");
+        }
+
+        for (uint32_t handle : handles)
+        {
+            remove(handle);
+        }
+    }
+
+    /// <summary>
+    /// Where a handle's object currently sits in the field arrays, INVALID_HANDLE if it isn't live.
+    /// </summary>
+    uint32_t get_dense_index(uint32_t handle) const
+    {
+        return sparse.get_dense_index(handle);
+    }
+
+    /// <summary>
+    /// Exchanges two objects' places in the field arrays. Their handles keep
+    /// referring to the same objects, so callers can keep dense ranges
+    /// partitioned (awake first, for example) without touching any handles.
+    /// </summary>
+    void swap_dense(size_t a, size_t b)
+    {
+        if (a == b)
+        {
+            return;
+        }
+        swap_fields(std::index_sequence_for<Fields...>{}, a, b);
+        std::swap(associated_handles[a], associated_handles[b]);
+        sparse.set_dense_index(associated_handles[a], a);
+        sparse.set_dense_index(associated_handles[b], b);
+    }
+
+    uint32_t get_associated_handle(size_t dense_index) const
+    {
+        if (dense_index < associated_handles.size())
+        {
+            return associated_handles[dense_index];
+        }
+        else
+        {
+            std::string message = std::string("SoASparseSet::GetAssociatedHandle() failed. Dense index is out of range.")
+                                + "\nDense index: " + std::to_string(dense_index)
+                                + "\nSize: " + std::to_string(associated_handles.size());
+            throw std::runtime_error(message);
+        }
+    }
+
+    /// <summary>
+    /// The contiguous array holding field I of every object, in dense order.
+    /// </summary>
+    template<size_t I>
+    auto& get_field()
+    {
+        return std::get<I>(dense);
+    }
+
+    template<size_t I>
+    const auto& get_field() const
+    {
+        return std::get<I>(dense);
+    }
+
+    size_t size() const
+    {
+        return associated_handles.size();
+    }
+
+    bool has(uint32_t handle) const
+    {
+        return sparse.contains(handle);
+    }
+
+    /// <summary>
+    /// Appends every field array, the handles and the handle slots to the writer.
+    /// </summary>
+    void save(SnapshotWriter& writer) const
+    {
+        std::apply([&writer](const auto&... field) { (writer.write_vector(field), ...); }, dense);
+        writer.write_vector(associated_handles);
+        sparse.save(writer);
+    }
+
+    /// <summary>
+    /// Replaces everything with what save() wrote, reusing the storage already
+    /// allocated. Returns whether any field or handle changed.
+    /// Throws if the snapshot doesn't describe a valid set, which leaves this
+    /// one unusable until a load() succeeds.
+    /// </summary>
+    bool load(SnapshotReader& reader)
+    {
+        // Comma folds run in order, which the reads have to.
+        bool changed = false;
+        std::apply([&reader, &changed](auto&... field) { ((changed = reader.read_vector(field) or changed), ...); }, dense);
+        changed = reader.read_vector(associated_handles) or changed;
+        sparse.load(reader);
+
+        bool sizes_match = std::apply([this](const auto&... field) { return ((field.size() == associated_handles.size()) and ...); }, dense);
+        if (not sizes_match)
+        {
+            throw std::runtime_error("SoASparseSet::Load() failed. The snapshot's field arrays and handles differ in length.");
+        }
+        if (not sparse.matches(associated_handles))
+        {
+            throw std::runtime_error("SoASparseSet::Load() failed. The snapshot's handles don't match its handle slots.");
+        }
+        return changed;
+    }
+};
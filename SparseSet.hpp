@@ -1,12 +1,14 @@
 #pragma once
+#include "PagedSparseArray.hpp"
+
 #include <vector>
+#include <span>
+#include <algorithm>
 #include <cstdint>
 #include <limits>
 #include <stdexcept>
 #include <string>
 
-constexpr uint32_t INVALID_HANDLE = std::numeric_limits<uint32_t>::max();
-
 template<typename T>
 class SparseSet
 {
@@ -14,64 +16,55 @@ class SparseSet
     
     std::vector<T>        dense{};
     std::vector<uint32_t> associated_handles{}; // for any index 'i' in dense_, associated_handles_ stores the handle
-    std::vector<uint32_t> sparse{};             // associated to the object at associated_handles_[i].
-
-    uint32_t              next_handle = 0;
-    std::vector<uint32_t> free_handles{};       // stores retired entity ids that can be reused
+    PagedSparseArray      sparse{};             // associated to the object at associated_handles_[i].
     
   public:
+    /// <param name="size">: objects to reserve room for up front, the set grows past it as needed</param>
     SparseSet(size_t size = 1000)
     {
-        sparse.resize(size, INVALID_HANDLE);
+        dense.reserve(size);
+        associated_handles.reserve(size);
+    }
+
+    void reserve(size_t count)
+    {
+        dense.reserve(count);
+        associated_handles.reserve(count);
     }
 
     uint32_t add(const T& object)
     {
-        uint32_t handle;
-        if (free_handles.empty())
-        {
-            handle = next_handle;
-            next_handle++;
-        }
-        else
-        {
-            handle = free_handles.back();
-            free_handles.pop_back();
-        }
+        uint32_t index  = dense.size();
+        uint32_t handle = sparse.allocate(index);
+        dense.push_back(object);
+        associated_handles.push_back(handle);
+        return handle;
+    }
 
-        if (sparse[handle] == INVALID_HANDLE)
-        {
-            uint32_t index = dense.size();
-            dense.push_back(object);
-            associated_handles.push_back(handle);
-            sparse[handle] = index;
-            return handle;
-        }
-        else
+    /// <summary>
+    /// Adds every object with a single reallocation at most.
+    /// </summary>
+    /// <param name="handles">: the new objects' handles are appended, in the same order</param>
+    void add_batch(std::span<const T> objects, std::vector<uint32_t>& handles)
+    {
+        reserve(dense.size() + objects.size());
+        handles.reserve(handles.size() + objects.size());
+        for (const T& object : objects)
         {
-            throw std::runtime_error("SparseSet::Add() failed. Handle already exists.");
+            handles.push_back(add(object));
         }
     }
 
     T& get(uint32_t handle)
     {
-        size_t index = 0;
-        if (handle < sparse.size())
-        {
-            index = sparse[handle];
-        }
-        else
-        {
-            throw std::runtime_error("SparseSet::Get() failed. Handle is out of range.");
-        }
-
+        uint32_t index = sparse.get_dense_index(handle);
         if (index != INVALID_HANDLE)
         {
             return dense[index];
         }
         else
         {
-            std::string message = std::string("SparseSet::Get() failed. Nothing exists at this handle -> ")
+            std::string message = std::string("SparseSet::Get() failed. Nothing exists at this handle, or it is stale -> ")
                                 + std::to_string(handle);
             throw std::runtime_error(message);
         }
@@ -79,35 +72,54 @@ class SparseSet
 
     void remove(uint32_t handle)
     {
-        if (handle < sparse.size())
+        uint32_t index_to_delete = sparse.get_dense_index(handle);
+        if (index_to_delete != INVALID_HANDLE)
         {
-            if (sparse[handle] != INVALID_HANDLE)
-            {
-                size_t index_to_delete = sparse[handle];
-                T last_object = dense.back();
-                uint32_t last_associated_handle = associated_handles.back();
+            uint32_t last_associated_handle = associated_handles.back();
 
-                dense[index_to_delete] = last_object;
-                associated_handles[index_to_delete] = last_associated_handle;
-                sparse[last_associated_handle] = index_to_delete;
+            dense[index_to_delete] = std::move(dense.back());
+            associated_handles[index_to_delete] = last_associated_handle;
+            sparse.set_dense_index(last_associated_handle, index_to_delete);
 
-                sparse[handle] = INVALID_HANDLE;
+            sparse.release(handle);
 
-                associated_handles.pop_back();
-                dense.pop_back();
-                free_handles.push_back(handle);
-            }
-            else
+            associated_handles.pop_back();
+            dense.pop_back();
+        }
+        else
+        {
+            throw std::runtime_error("SparseSet::Delete() failed. Nothing exists at this handle, or it is stale.");
+        }
+    }
+
+    /// <summary>
+    /// Removes every object in one pass. Throws, with nothing removed, if any
+    /// handle isn't live or the same handle is given twice.
+    /// </summary>
+    void remove_batch(std::span<const uint32_t> handles)
+    {
+        std::vector<uint32_t> indices;
+        indices.reserve(handles.size());
+        for (uint32_t handle : handles)
+        {
+            uint32_t index = sparse.get_dense_index(handle);
+            if (index == INVALID_HANDLE)
             {
-                throw std::runtime_error("SparseSet::Delete() failed. Nothing exists at this handle.");
+                throw std::runtime_error("SparseSet::DeleteBatch() failed. Nothing exists at this handle, or it is stale.");
             }
-
+            indices.push_back(index);
         }
-        else
+
+        std::sort(indices.begin(), indices.end());
+        if (std::adjacent_find(indices.begin(), indices.end()) != indices.end())
         {
-            throw std::runtime_error("SparseSet::Delete() failed. Handle is out of range.");
+            throw std::runtime_error("SparseSet::DeleteBatch() failed. The same handle is given more than once.");
         }
 
+        for (uint32_t handle : handles)
+        {
+            remove(handle);
+        }
     }
 
     uint32_t get_associated_handle(size_t dense_index)
@@ -136,6 +148,38 @@ class SparseSet
 
     bool has(uint32_t handle)
     {
-        return (handle < sparse.size() and sparse[handle] != INVALID_HANDLE);
+        return sparse.contains(handle);
+    }
+
+    /// <summary>
+    /// Appends the objects, their handles and the handle slots to the writer.
+    /// </summary>
+    void save(SnapshotWriter& writer) const
+    {
+        writer.write_vector(dense);
+        writer.write_vector(associated_handles);
+        sparse.save(writer);
+    }
+
+    /// <summary>
+    /// Replaces everything with what save() wrote, reusing the storage already
+    /// allocated. Returns whether the objects or their handles changed.
+    /// Throws if the snapshot doesn't describe a valid set, which leaves this
+    /// one unusable until a load() succeeds.
+    /// </summary>
+    bool load(SnapshotReader& reader)
+    {
+        bool changed = reader.read_vector(dense);
+        changed      = reader.read_vector(associated_handles) or changed;
+        sparse.load(reader);
+        if (dense.size() != associated_handles.size())
+        {
+            throw std::runtime_error("SparseSet::Load() failed. The snapshot has a different number of objects and handles.");
+        }
+        if (not sparse.matches(associated_handles))
+        {
+            throw std::runtime_error("SparseSet::Load() failed. The snapshot's handles don't match its handle slots.");
+        }
+        return changed;
     }
 };
@@ -0,0 +1,93 @@
+#include "SpatialHash.hpp"
+
+phys::SpatialHash::SpatialHash(float cell_size)
+    :
+    cell_size(cell_size)
+{
+}
+
+int32_t phys::SpatialHash::to_cell(float coordinate) const
+{
+    return static_cast<int32_t>(std::floor(coordinate / cell_size));
+}
+
+uint64_t phys::SpatialHash::make_key(int32_t x, int32_t y, int32_t z)
+{
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    return  (static_cast<uint64_t>(x) & mask)
+         | ((static_cast<uint64_t>(y) & mask) << 21)
+         | ((static_cast<uint64_t>(z) & mask) << 42);
+}
+
+void phys::SpatialHash::insert(uint32_t handle, const glm::vec3& min, const glm::vec3& max)
+{
+    for (int32_t x = to_cell(min.x); x <= to_cell(max.x); x++)
+    {
+        for (int32_t y = to_cell(min.y); y <= to_cell(max.y); y++)
+        {
+            for (int32_t z = to_cell(min.z); z <= to_cell(max.z); z++)
+            {
+                cells[make_key(x, y, z)].push_back(handle);
+            }
+        }
+    }
+}
+
+void phys::SpatialHash::remove(uint32_t handle, const glm::vec3& min, const glm::vec3& max)
+{
+    for (int32_t x = to_cell(min.x); x <= to_cell(max.x); x++)
+    {
+        for (int32_t y = to_cell(min.y); y <= to_cell(max.y); y++)
+        {
+            for (int32_t z = to_cell(min.z); z <= to_cell(max.z); z++)
+            {
+                auto cell = cells.find(make_key(x, y, z));
+                if (cell == cells.end())
+                {
+                    continue;
+                }
+
+                std::vector<uint32_t>& handles = cell->second;
+                auto it = std::find(handles.begin(), handles.end(), handle);
+                if (it != handles.end())
+                {
+                    *it = handles.back();
+                    handles.pop_back();
+                }
+
+                if (handles.empty())
+                {
+                    cells.erase(cell);
+                }
+            }
+        }
+    }
+}
+
+void phys::SpatialHash::query(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const
+{
+    out.clear();
+    for (int32_t x = to_cell(min.x); x <= to_cell(max.x); x++)
+    {
+        for (int32_t y = to_cell(min.y); y <= to_cell(max.y); y++)
+        {
+            for (int32_t z = to_cell(min.z); z <= to_cell(max.z); z++)
+            {
+                auto cell = cells.find(make_key(x, y, z));
+                if (cell != cells.end())
+                {
+                    out.insert(out.end(), cell->second.begin(), cell->second.end());
+                }
+            }
+        }
+    }
+
+    // Objects spanning more than one cell were picked up once per cell.
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void phys::SpatialHash::clear()
+{
+    cells.clear();
+}
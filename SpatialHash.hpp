@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+/// <summary>
+/// Uniform grid broadphase, hashed so that only occupied cells take up memory.
+/// An object is stored in every cell its AABB covers, so a query only has to
+/// look at the cells covered by the box it is given.
+/// </summary>
+class SpatialHash
+{
+  private:
+    float                                               cell_size;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells{};
+
+    int32_t to_cell(float coordinate) const;
+
+    /// <summary>
+    /// Packs three signed cell coordinates into one key, 21 bits per axis.
+    /// </summary>
+    static uint64_t make_key(int32_t x, int32_t y, int32_t z);
+
+  public:
+    SpatialHash(float cell_size = 1.0f);
+
+    void insert(uint32_t handle, const glm::vec3& min, const glm::vec3& max);
+
+    void remove(uint32_t handle, const glm::vec3& min, const glm::vec3& max);
+
+    /// <summary>
+    /// Collects the handles of every object sharing a cell with the given box.
+    /// Each handle appears in the output once, even if it spans several cells.
+    /// </summary>
+    /// <param name="out">: cleared, then filled with candidate handles</param>
+    void query(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const;
+
+    void clear();
+};
+
+}
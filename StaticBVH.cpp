@@ -0,0 +1,359 @@
+#include "StaticBVH.hpp"
+
+namespace
+{
+
+float surface_area(const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Spreads the low 10 bits of v out so there are two zero bits between each.
+uint32_t expand_bits(uint32_t v)
+{
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+uint32_t morton_code(const glm::vec3& unit_point)
+{
+    glm::vec3 p = glm::clamp(unit_point * 1024.0f, glm::vec3(0.0f), glm::vec3(1023.0f));
+    return (expand_bits(static_cast<uint32_t>(p.x)) << 2)
+         | (expand_bits(static_cast<uint32_t>(p.y)) << 1)
+         |  expand_bits(static_cast<uint32_t>(p.z));
+}
+
+}
+
+int32_t phys::StaticBVH::allocate_node()
+{
+    if (free_list != -1)
+    {
+        int32_t index = free_list;
+        free_list = nodes[index].left;
+        return index;
+    }
+    nodes.push_back({});
+    return static_cast<int32_t>(nodes.size() - 1);
+}
+
+void phys::StaticBVH::free_node(int32_t index)
+{
+    nodes[index].height = -1;
+    nodes[index].left   = free_list;
+    free_list = index;
+}
+
+void phys::StaticBVH::refit(int32_t index)
+{
+    while (index != -1)
+    {
+        BVHNode&       node  = nodes[index];
+        const BVHNode& left  = nodes[node.left];
+        const BVHNode& right = nodes[node.right];
+
+        node.min    = glm::min(left.min, right.min);
+        node.max    = glm::max(left.max, right.max);
+        node.height = 1 + std::max(left.height, right.height);
+
+        index = node.parent;
+    }
+}
+
+int32_t phys::StaticBVH::build_range(std::vector<BVHItem>& items, const std::vector<uint32_t>& codes,
+                                     size_t first, size_t last, int32_t parent)
+{
+    int32_t index = static_cast<int32_t>(nodes.size());
+    nodes.push_back({});
+
+    if (first == last)
+    {
+        nodes[index] = { items[first].min, items[first].max, parent, -1, -1, 0, items[first].handle };
+        leaf_of[items[first].handle] = index;
+        return index;
+    }
+
+    // Split where the highest differing Morton bit flips, so each child covers
+    // one half of the space its parent covers. Identical codes split in the middle.
+    size_t split = (first + last) / 2;
+    if (codes[first] != codes[last])
+    {
+        int prefix = std::countl_zero(codes[first] ^ codes[last]);
+        size_t low  = first;
+        size_t high = last;
+        while (low + 1 < high)
+        {
+            size_t middle = (low + high) / 2;
+            if (std::countl_zero(codes[first] ^ codes[middle]) > prefix)
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        split = low;
+    }
+
+    // Children are written straight after their parent, left subtree first.
+    int32_t left  = build_range(items, codes, first, split, index);
+    int32_t right = build_range(items, codes, split + 1, last, index);
+
+    nodes[index].parent = parent;
+    nodes[index].left   = left;
+    nodes[index].right  = right;
+    nodes[index].min    = glm::min(nodes[left].min, nodes[right].min);
+    nodes[index].max    = glm::max(nodes[left].max, nodes[right].max);
+    nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+    return index;
+}
+
+void phys::StaticBVH::build(std::vector<BVHItem> items)
+{
+    clear();
+    if (items.empty())
+    {
+        return;
+    }
+
+    glm::vec3 scene_min = (items[0].min + items[0].max) * 0.5f;
+    glm::vec3 scene_max = scene_min;
+    for (const BVHItem& item : items)
+    {
+        glm::vec3 center = (item.min + item.max) * 0.5f;
+        scene_min = glm::min(scene_min, center);
+        scene_max = glm::max(scene_max, center);
+    }
+    glm::vec3 scene_size = glm::max(scene_max - scene_min, glm::vec3(1e-6f));
+
+    std::vector<std::pair<uint32_t, size_t>> keyed(items.size());
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        glm::vec3 center = (items[i].min + items[i].max) * 0.5f;
+        keyed[i] = { morton_code((center - scene_min) / scene_size), i };
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<BVHItem>  sorted_items(items.size());
+    std::vector<uint32_t> codes(items.size());
+    for (size_t i = 0; i < keyed.size(); i++)
+    {
+        codes[i]        = keyed[i].first;
+        sorted_items[i] = items[keyed[i].second];
+    }
+
+    nodes.reserve(2 * items.size() - 1);
+    leaf_of.reserve(items.size());
+    root = build_range(sorted_items, codes, 0, sorted_items.size() - 1, -1);
+}
+
+void phys::StaticBVH::rebuild()
+{
+    index_leaves();
+    std::vector<BVHItem> items;
+    items.reserve(leaf_of.size());
+    for (auto& [handle, leaf] : leaf_of)
+    {
+        items.push_back({ handle, nodes[leaf].min, nodes[leaf].max });
+    }
+    build(std::move(items));
+}
+
+void phys::StaticBVH::index_leaves()
+{
+    if (not leaf_of_stale)
+    {
+        return;
+    }
+    leaf_of.reserve(nodes.size() / 2 + 1);
+    for (int32_t i = 0; i < int32_t(nodes.size()); i++)
+    {
+        if (nodes[i].left == -1 and nodes[i].height == 0)
+        {
+            leaf_of[nodes[i].handle] = i;
+        }
+    }
+    leaf_of_stale = false;
+}
+
+void phys::StaticBVH::insert(uint32_t handle, const glm::vec3& min, const glm::vec3& max)
+{
+    index_leaves();
+    if (leaf_of.contains(handle))
+    {
+        throw std::runtime_error("phys::StaticBVH::insert() failed. Handle is already in the tree.");
+    }
+
+    int32_t leaf = allocate_node();
+    nodes[leaf] = { min, max, -1, -1, -1, 0, handle };
+    leaf_of[handle] = leaf;
+
+    if (root == -1)
+    {
+        root = leaf;
+        return;
+    }
+
+    // Walk down towards the sibling that grows the total surface area the least.
+    int32_t index = root;
+    while (nodes[index].left != -1)
+    {
+        const BVHNode& node = nodes[index];
+
+        float area          = surface_area(node.min, node.max);
+        float combined_area = surface_area(glm::min(node.min, min), glm::max(node.max, max));
+
+        float cost_here   = 2.0f * combined_area;
+        float inheritance = 2.0f * (combined_area - area);
+
+        float child_cost[2];
+        int32_t children[2] = { node.left, node.right };
+        for (int c = 0; c < 2; c++)
+        {
+            const BVHNode& child = nodes[children[c]];
+            float enlarged = surface_area(glm::min(child.min, min), glm::max(child.max, max));
+            child_cost[c]  = inheritance + ((child.left == -1) ? enlarged : enlarged - surface_area(child.min, child.max));
+        }
+
+        if (cost_here < child_cost[0] and cost_here < child_cost[1])
+        {
+            break;
+        }
+        index = (child_cost[0] < child_cost[1]) ? node.left : node.right;
+    }
+
+    int32_t sibling    = index;
+    int32_t old_parent = nodes[sibling].parent;
+    int32_t new_parent = allocate_node();
+
+    nodes[new_parent]        = { glm::vec3(0.0f), glm::vec3(0.0f), old_parent, sibling, leaf, 0, 0 };
+    nodes[sibling].parent    = new_parent;
+    nodes[leaf].parent       = new_parent;
+
+    if (old_parent == -1)
+    {
+        root = new_parent;
+    }
+    else if (nodes[old_parent].left == sibling)
+    {
+        nodes[old_parent].left = new_parent;
+    }
+    else
+    {
+        nodes[old_parent].right = new_parent;
+    }
+
+    refit(new_parent);
+
+    if (nodes[root].height > MAX_HEIGHT)
+    {
+        rebuild();
+    }
+}
+
+void phys::StaticBVH::remove(uint32_t handle)
+{
+    index_leaves();
+    auto found = leaf_of.find(handle);
+    if (found == leaf_of.end())
+    {
+        throw std::runtime_error("phys::StaticBVH::remove() failed. Handle is not in the tree.");
+    }
+
+    int32_t leaf = found->second;
+    leaf_of.erase(found);
+
+    if (leaf == root)
+    {
+        free_node(leaf);
+        root = -1;
+        return;
+    }
+
+    // The leaf's sibling takes the place of their shared parent.
+    int32_t parent       = nodes[leaf].parent;
+    int32_t grand_parent = nodes[parent].parent;
+    int32_t sibling      = (nodes[parent].left == leaf) ? nodes[parent].right : nodes[parent].left;
+
+    if (grand_parent == -1)
+    {
+        root = sibling;
+        nodes[sibling].parent = -1;
+    }
+    else
+    {
+        if (nodes[grand_parent].left == parent)
+        {
+            nodes[grand_parent].left = sibling;
+        }
+        else
+        {
+            nodes[grand_parent].right = sibling;
+        }
+        nodes[sibling].parent = grand_parent;
+        refit(grand_parent);
+    }
+
+    free_node(parent);
+    free_node(leaf);
+}
+
+void phys::StaticBVH::query(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const
+{
+    out.clear();
+    if (root == -1)
+    {
+        return;
+    }
+
+    // Depth first, so the stack never holds more than one entry per level plus one.
+    int32_t stack[2 * MAX_HEIGHT + 2];
+    size_t  top = 0;
+    stack[top++] = root;
+
+    while (top > 0)
+    {
+        const BVHNode& node = nodes[stack[--top]];
+
+        if (node.max.x < min.x or node.min.x > max.x or
+            node.max.y < min.y or node.min.y > max.y or
+            node.max.z < min.z or node.min.z > max.z)
+        {
+            continue;
+        }
+
+        if (node.left == -1)
+        {
+            out.push_back(node.handle);
+        }
+        else
+        {
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+}
+
+void phys::StaticBVH::clear()
+{
+    nodes.clear();
+    leaf_of.clear();
+    leaf_of_stale = false;
+    root      = -1;
+    free_list = -1;
+}
+
+const std::vector<phys::BVHNode>& phys::StaticBVH::get_nodes() const
+{
+    return nodes;
+}
+
+int32_t phys::StaticBVH::get_root() const
+{
+    return root;
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+struct BVHNode
+{
+    glm::vec3 min;
+    glm::vec3 max;
+    int32_t   parent;
+    int32_t   left;   // -1 for leaves. Next free node while on the free list.
+    int32_t   right;
+    int32_t   height; // 0 for leaves, -1 while on the free list
+    uint32_t  handle; // only meaningful for leaves
+};
+
+struct BVHItem
+{
+    uint32_t  handle;
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+/// <summary>
+/// Bounding volume hierarchy over objects that rarely move. All nodes live in one
+/// flat array; a bulk build lays them out depth first, so walking down the left
+/// side of the tree walks forward through memory. Single inserts and removals
+/// patch the tree in place and it rebuilds itself if that lets it get too deep.
+/// </summary>
+class StaticBVH
+{
+  private:
+    static constexpr int32_t MAX_HEIGHT = 64; // also bounds the traversal stack in query()
+
+    std::vector<BVHNode>                  nodes{};
+    int32_t                               root      = -1;
+    int32_t                               free_list = -1;
+    std::unordered_map<uint32_t, int32_t> leaf_of{}; // handle -> leaf node
+    bool                                  leaf_of_stale = false; // load() leaves it empty until something needs it
+
+    int32_t allocate_node();
+
+    void free_node(int32_t index);
+
+    /// <summary>
+    /// Recomputes bounds and heights from the given node up to the root.
+    /// </summary>
+    void refit(int32_t index);
+
+    /// <summary>
+    /// Fills leaf_of from the leaves if load() left it stale.
+    /// </summary>
+    void index_leaves();
+
+    /// <summary>
+    /// Whether the node's box covers the given one. False if either holds a NaN.
+    /// </summary>
+    static bool contains(const BVHNode& node, const glm::vec3& min, const glm::vec3& max)
+    {
+        return node.min.x <= min.x and node.min.y <= min.y and node.min.z <= min.z and
+               max.x <= node.max.x and max.y <= node.max.y and max.z <= node.max.z;
+    }
+
+    int32_t build_range(std::vector<BVHItem>& items, const std::vector<uint32_t>& codes,
+                        size_t first, size_t last, int32_t parent);
+
+  public:
+    /// <summary>
+    /// Throws away the current tree and bulk builds a new one, ordering the items
+    /// along a Morton curve and splitting wherever their codes first differ.
+    /// </summary>
+    void build(std::vector<BVHItem> items);
+
+    /// <summary>
+    /// Bulk builds again from the current leaves. Compacts the node array.
+    /// </summary>
+    void rebuild();
+
+    /// <summary>
+    /// Throws away the current tree and copies in one built earlier, e.g. kept
+    /// in a level file. Leaf handles in the given nodes are indices into
+    /// handles and are swapped for the handle found there. Throws, without
+    /// changing the current tree, unless the nodes form one tree holding every
+    /// handle exactly once with every box covering what is below it, see the
+    /// checks in the definition.
+    /// </summary>
+    /// <param name="get_bounds">: callable (uint32_t index, glm::vec3& min, glm::vec3& max), the bounds of the object at handles[index]</param>
+    template<typename BoundsFunction>
+    void load(std::span<const BVHNode> tree, int32_t tree_root, std::span<const uint32_t> handles, BoundsFunction get_bounds);
+
+    void insert(uint32_t handle, const glm::vec3& min, const glm::vec3& max);
+
+    void remove(uint32_t handle);
+
+    /// <summary>
+    /// Collects the handles of every leaf whose box touches the given box.
+    /// </summary>
+    /// <param name="out">: cleared, then filled with candidate handles</param>
+    void query(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const;
+
+    void clear();
+
+    const std::vector<BVHNode>& get_nodes() const;
+
+    int32_t get_root() const;
+};
+
+template<typename BoundsFunction>
+void StaticBVH::load(std::span<const BVHNode> tree, int32_t tree_root, std::span<const uint32_t> handles, BoundsFunction get_bounds)
+{
+    // A tree over n leaves has exactly 2n - 1 nodes.
+    size_t expected = handles.empty() ? 0 : 2 * handles.size() - 1;
+    if (tree.size() != expected or tree.size() > size_t(INT32_MAX) or
+        tree_root < -1 or tree_root >= int32_t(tree.size()) or (tree_root == -1) != tree.empty())
+    {
+        throw std::runtime_error("phys::StaticBVH::load() failed. Node count or root doesn't match the number of handles.");
+    }
+
+    // Every node but the root is claimed by the parent it names, and children
+    // are strictly lower than their parent. That rules out cycles and shared
+    // nodes, and the root's height then bounds what query() keeps a stack for.
+    // query() skips a subtree whose box misses, so each leaf's box has to cover
+    // its object and each parent's box its children's, or objects go missing.
+    int32_t           count = int32_t(tree.size());
+    std::vector<bool> seen(handles.size(), false);
+    for (int32_t i = 0; i < count; i++)
+    {
+        const BVHNode& node = tree[i];
+
+        bool valid;
+        if (i == tree_root)
+        {
+            valid = node.parent == -1;
+        }
+        else
+        {
+            valid = node.parent >= 0 and node.parent < count and
+                    (tree[node.parent].left == i or tree[node.parent].right == i);
+        }
+
+        if (node.left == -1)
+        {
+            valid = valid and node.height == 0 and node.handle < handles.size() and not seen[node.handle];
+            if (valid)
+            {
+                seen[node.handle] = true;
+
+                glm::vec3 min;
+                glm::vec3 max;
+                get_bounds(node.handle, min, max);
+                valid = contains(node, min, max);
+            }
+        }
+        else
+        {
+            valid = valid and node.height > 0 and node.height <= MAX_HEIGHT and node.left != node.right and
+                    node.left >= 0 and node.left < count and node.right >= 0 and node.right < count and
+                    tree[node.left].parent == i and tree[node.right].parent == i and
+                    tree[node.left].height < node.height and tree[node.right].height < node.height and
+                    contains(node, tree[node.left].min, tree[node.left].max) and contains(node, tree[node.right].min, tree[node.right].max);
+        }
+
+        if (not valid)
+        {
+            throw std::runtime_error("phys::StaticBVH::load() failed. Nodes don't describe a valid tree over the handles.");
+        }
+    }
+
+    nodes.assign(tree.begin(), tree.end());
+    for (BVHNode& node : nodes)
+    {
+        if (node.left == -1)
+        {
+            node.handle = handles[node.handle];
+        }
+    }
+    root      = tree_root;
+    free_list = -1;
+
+    // Indexing every leaf costs an allocation per leaf, which is most of what
+    // loading a prebuilt tree saves, and queries never need it.
+    leaf_of.clear();
+    leaf_of_stale = true;
+}
+
+}
@@ -0,0 +1,90 @@
+#include "SweepAndPrune.hpp"
+
+void phys::SweepAndPrune::insertion_sort()
+{
+    for (size_t i = 1; i < entries.size(); i++)
+    {
+        Entry  entry = entries[i];
+        size_t j     = i;
+        while (j > 0 and entries[j - 1].min[axis] > entry.min[axis])
+        {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+}
+
+void phys::SweepAndPrune::insert(uint32_t handle, const glm::vec3& min, const glm::vec3& max)
+{
+    Entry entry = { handle, min, max };
+    auto position = std::upper_bound
+    (
+        entries.begin(), entries.end(), entry,
+        [this](const Entry& a, const Entry& b) { return a.min[axis] < b.min[axis]; }
+    );
+    entries.insert(position, entry);
+}
+
+void phys::SweepAndPrune::remove(uint32_t handle)
+{
+    auto it = std::find_if(entries.begin(), entries.end(), [handle](const Entry& e) { return e.handle == handle; });
+    if (it != entries.end())
+    {
+        // erase rather than swap so the sorted order survives
+        entries.erase(it);
+    }
+}
+
+void phys::SweepAndPrune::remove_batch(std::span<const uint32_t> handles)
+{
+    std::vector<uint32_t> sorted(handles.begin(), handles.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    // remove_if keeps the survivors in order, so the sort along the axis holds.
+    auto removed = std::remove_if(entries.begin(), entries.end(), [&sorted](const Entry& e)
+    {
+        return std::binary_search(sorted.begin(), sorted.end(), e.handle);
+    });
+    entries.erase(removed, entries.end());
+}
+
+void phys::SweepAndPrune::find_pairs(std::vector<std::pair<uint32_t, uint32_t>>& out) const
+{
+    out.clear();
+
+    int axis_1 = (axis + 1) % 3;
+    int axis_2 = (axis + 2) % 3;
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const Entry& a = entries[i];
+        for (size_t j = i + 1; j < entries.size() and entries[j].min[axis] < a.max[axis]; j++)
+        {
+            const Entry& b = entries[j];
+            if (a.min[axis_1] < b.max[axis_1] and b.min[axis_1] < a.max[axis_1] and
+                a.min[axis_2] < b.max[axis_2] and b.min[axis_2] < a.max[axis_2])
+            {
+                out.emplace_back(a.handle, b.handle);
+            }
+        }
+    }
+}
+
+void phys::SweepAndPrune::save(SnapshotWriter& writer) const
+{
+    writer.write_vector(entries);
+    writer.write_value(axis);
+    writer.write_value(max_size);
+}
+
+void phys::SweepAndPrune::load(SnapshotReader& reader)
+{
+    reader.read_vector(entries);
+    axis     = reader.read_value<int>();
+    max_size = reader.read_value<glm::vec3>();
+    if (axis < 0 or axis > 2)
+    {
+        throw std::runtime_error("phys::SweepAndPrune::load() failed. Sweep axis is out of range.");
+    }
+}
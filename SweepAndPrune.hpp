@@ -0,0 +1,245 @@
+#pragma once
+#include "SnapshotStream.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <utility>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+/// <summary>
+/// Sort-and-sweep broadphase for objects that move every step. Entries stay
+/// sorted by their minimum along the sweep axis between calls to update(), so
+/// when objects only move a little the insertion sort there is close to linear.
+/// </summary>
+class SweepAndPrune
+{
+  private:
+    // How much more spread out along another axis the centers have to be before
+    // update() switches to it, so two axes with similar spread don't take turns.
+    static constexpr double AXIS_SWITCH_RATIO = 1.5;
+
+    struct Entry
+    {
+        uint32_t  handle;
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    std::vector<Entry> entries{};
+    int                axis     = 0;                 // axis the entries are sorted along
+    glm::vec3          max_size = glm::vec3(0.0f);   // largest entry along each axis, as of the last update()
+
+    void insertion_sort();
+
+  public:
+    void insert(uint32_t handle, const glm::vec3& min, const glm::vec3& max);
+
+    void remove(uint32_t handle);
+
+    /// <summary>
+    /// Same result as calling insert() for each handle in order, but sorts once
+    /// at the end instead of shifting the entries for every insert.
+    /// </summary>
+    /// <param name="get_bounds">: callable (uint32_t handle, glm::vec3& min, glm::vec3& max)</param>
+    template<typename BoundsFunction>
+    void insert_batch(std::span<const uint32_t> handles, BoundsFunction get_bounds);
+
+    /// <summary>
+    /// Removes every given handle in a single pass over the entries.
+    /// </summary>
+    void remove_batch(std::span<const uint32_t> handles);
+
+    /// <summary>
+    /// Refreshes every entry's bounds, switches the sweep axis once object
+    /// centers are clearly more spread out along another one, and restores
+    /// sorted order.
+    /// </summary>
+    /// <param name="get_bounds">: callable (uint32_t handle, glm::vec3& min, glm::vec3& max)</param>
+    template<typename BoundsFunction>
+    void update(BoundsFunction get_bounds);
+
+    /// <summary>
+    /// Sweeps the sorted entries and collects every pair whose AABBs overlap.
+    /// </summary>
+    /// <param name="out">: cleared, then filled with overlapping handle pairs</param>
+    void find_pairs(std::vector<std::pair<uint32_t, uint32_t>>& out) const;
+
+    /// <summary>
+    /// Like find_pairs(), but skips pairs where neither entry is active, and
+    /// only sweeps from the active entries, so inactive (sleeping) objects cost
+    /// next to nothing. With every entry active the output matches find_pairs().
+    /// </summary>
+    /// <param name="is_active">: callable (uint32_t handle) -> bool</param>
+    template<typename ActiveFunction>
+    void find_active_pairs(std::vector<std::pair<uint32_t, uint32_t>>& out, ActiveFunction is_active);
+
+    /// <summary>
+    /// Appends the entries, in their sorted order, and the sweep axis to the writer.
+    /// </summary>
+    void save(SnapshotWriter& writer) const;
+
+    /// <summary>
+    /// Replaces everything with what save() wrote. The order comes back as it
+    /// was saved, so pairs come out of the next sweep in the same order too.
+    /// </summary>
+    void load(SnapshotReader& reader);
+
+    /// <summary>
+    /// Whether the entries are sorted along the sweep axis and hold each of
+    /// count objects exactly once, e.g. after a load().
+    /// </summary>
+    /// <param name="get_index">: callable (uint32_t handle) -> the object's index below count, INVALID_HANDLE if it isn't one</param>
+    template<typename IndexFunction>
+    bool matches(size_t count, IndexFunction get_index) const;
+};
+
+template<typename BoundsFunction>
+void SweepAndPrune::insert_batch(std::span<const uint32_t> handles, BoundsFunction get_bounds)
+{
+    size_t old_size = entries.size();
+    entries.reserve(old_size + handles.size());
+    for (uint32_t handle : handles)
+    {
+        Entry entry = { handle, glm::vec3(0.0f), glm::vec3(0.0f) };
+        get_bounds(handle, entry.min, entry.max);
+        entries.push_back(entry);
+    }
+
+    // Stable, so new entries land after existing equal ones just like upper_bound in insert().
+    auto by_min = [this](const Entry& a, const Entry& b) { return a.min[axis] < b.min[axis]; };
+    std::stable_sort(entries.begin() + old_size, entries.end(), by_min);
+    std::inplace_merge(entries.begin(), entries.begin() + old_size, entries.end(), by_min);
+}
+
+template<typename BoundsFunction>
+void SweepAndPrune::update(BoundsFunction get_bounds)
+{
+    if (entries.empty())
+    {
+        return;
+    }
+
+    // Centers are summed relative to the first one, in double, so the variance
+    // doesn't drown in rounding when objects sit far from the origin.
+    double sum[3]         = { 0.0, 0.0, 0.0 };
+    double sum_squares[3] = { 0.0, 0.0, 0.0 };
+    max_size = glm::vec3(0.0f);
+
+    glm::vec3 shift = glm::vec3(0.0f);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        Entry& entry = entries[i];
+        get_bounds(entry.handle, entry.min, entry.max);
+
+        glm::vec3 center = (entry.min + entry.max) * 0.5f;
+        if (i == 0)
+        {
+            shift = center;
+        }
+        for (int a = 0; a < 3; a++)
+        {
+            double offset   = double(center[a]) - double(shift[a]);
+            sum[a]         += offset;
+            sum_squares[a] += offset * offset;
+        }
+        max_size = glm::max(max_size, entry.max - entry.min);
+    }
+
+    double count = double(entries.size());
+    double variance[3];
+    int    widest = 0;
+    for (int a = 0; a < 3; a++)
+    {
+        double mean = sum[a] / count;
+        variance[a] = sum_squares[a] / count - mean * mean;
+        if (variance[a] > variance[widest])
+        {
+            widest = a;
+        }
+    }
+
+    if (widest != axis and variance[widest] > variance[axis] * AXIS_SWITCH_RATIO)
+    {
+        // The old order says little about the new axis, so sort from scratch.
+        // Stable, so equal entries keep their order like with insertion_sort().
+        axis = widest;
+        std::stable_sort(entries.begin(), entries.end(), [this](const Entry& a, const Entry& b) { return a.min[axis] < b.min[axis]; });
+    }
+    else
+    {
+        insertion_sort();
+    }
+}
+
+template<typename IndexFunction>
+bool SweepAndPrune::matches(size_t count, IndexFunction get_index) const
+{
+    if (entries.size() != count)
+    {
+        return false;
+    }
+
+    std::vector<bool> seen(count, false);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        uint32_t index = get_index(entries[i].handle);
+        if (index >= count or seen[index] or (i > 0 and entries[i - 1].min[axis] > entries[i].min[axis]))
+        {
+            return false;
+        }
+        seen[index] = true;
+    }
+    return true;
+}
+
+template<typename ActiveFunction>
+void SweepAndPrune::find_active_pairs(std::vector<std::pair<uint32_t, uint32_t>>& out, ActiveFunction is_active)
+{
+    out.clear();
+
+    int axis_1 = (axis + 1) % 3;
+    int axis_2 = (axis + 2) % 3;
+
+    auto overlap = [axis_1, axis_2](const Entry& a, const Entry& b)
+    {
+        return a.min[axis_1] < b.max[axis_1] and b.min[axis_1] < a.max[axis_1] and
+               a.min[axis_2] < b.max[axis_2] and b.min[axis_2] < a.max[axis_2];
+    };
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const Entry& a = entries[i];
+        if (not is_active(a.handle))
+        {
+            continue;
+        }
+
+        // Inactive entries before this one never sweep, so look back for them.
+        // Nothing starting more than max_size earlier can still reach a.
+        for (size_t j = i; j-- > 0 and entries[j].min[axis] > a.min[axis] - max_size[axis];)
+        {
+            const Entry& b = entries[j];
+            if (b.max[axis] > a.min[axis] and overlap(a, b) and not is_active(b.handle))
+            {
+                out.emplace_back(b.handle, a.handle);
+            }
+        }
+
+        for (size_t j = i + 1; j < entries.size() and entries[j].min[axis] < a.max[axis]; j++)
+        {
+            const Entry& b = entries[j];
+            if (overlap(a, b))
+            {
+                out.emplace_back(a.handle, b.handle);
+            }
+        }
+    }
+}
+
+}
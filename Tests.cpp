@@ -0,0 +1,411 @@
+#include "JobSystem.hpp"
+#include "PhysicsSystem.hpp"
+#include "StaticBVH.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Checks for behaviour that is easy to break without it showing up in the demo:
+//   physics-tests
+// Each test prints ok or the checks it failed, and the exit code is non zero if
+// any check failed.
+
+namespace
+{
+
+int failed_checks = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (not condition)
+    {
+        std::cout << std::format("    failed: {}", what) << std::endl;
+        failed_checks++;
+    }
+}
+
+void test_parallel_for_rethrows()
+{
+    phys::JobSystem jobs(4);
+
+    std::atomic<size_t> started  = 0;
+    std::atomic<size_t> finished = 0;
+    std::string         message;
+    try
+    {
+        jobs.parallel_for(1000, 10, [&](const phys::JobRange& range)
+        {
+            started++;
+            if (range.chunk == 37)
+            {
+                throw std::runtime_error("chunk 37");
+            }
+            finished++;
+        });
+    }
+    catch (const std::runtime_error& exception)
+    {
+        message = exception.what();
+    }
+    check(message == "chunk 37", "the body's exception reaches the caller");
+    check(started == finished + 1, "every chunk that started has finished by the time parallel_for throws");
+
+    // The pool keeps working afterwards.
+    std::atomic<size_t> sum = 0;
+    jobs.parallel_for(1000, 10, [&sum](const phys::JobRange& range)
+    {
+        for (size_t i = range.begin; i < range.end; i++)
+        {
+            sum += i;
+        }
+    });
+    check(sum == 999 * 1000 / 2, "parallel_for after a throw covers every index");
+}
+
+// A floor and a stack of boxes left to settle until the whole stack sleeps.
+std::vector<phys::DynamicID> make_sleeping_stack(phys::PhysicsSystem& physics, size_t height)
+{
+    for (int x = -3; x <= 3; x++)
+    {
+        for (int z = -3; z <= 3; z++)
+        {
+            physics.add_static(glm::vec3(float(x), -1.0f, float(z)));
+        }
+    }
+
+    std::vector<phys::DynamicID> stack;
+    for (size_t i = 0; i < height; i++)
+    {
+        stack.push_back(physics.add_dynamic(glm::vec3(0.0f, 0.05f + 1.02f * float(i), 0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f));
+    }
+
+    for (int tick = 0; tick < 600 and not physics.is_sleeping(stack.back()); tick++)
+    {
+        physics.step(1.0f / 60.0f);
+    }
+    return stack;
+}
+
+void test_removing_sleeping_body_wakes_island()
+{
+    for (bool batch : { false, true })
+    {
+        phys::PhysicsSystem          physics(std::make_shared<phys::JobSystem>(1));
+        std::vector<phys::DynamicID> stack = make_sleeping_stack(physics, 3);
+        for (phys::DynamicID id : stack)
+        {
+            check(physics.is_sleeping(id), "the stack falls asleep");
+        }
+
+        float top_before = physics.get_dynamic(stack.back()).position.y;
+        if (batch)
+        {
+            physics.remove_dynamics(std::span<const phys::DynamicID>(stack.data(), 1));
+        }
+        else
+        {
+            physics.remove_dynamic(stack[0]);
+        }
+        check(not physics.is_sleeping(stack[1]) and not physics.is_sleeping(stack[2]),
+              std::format("the boxes above wake when the bottom one is removed (batch {})", batch));
+
+        for (int tick = 0; tick < 60; tick++)
+        {
+            physics.step(1.0f / 60.0f);
+        }
+        check(physics.get_dynamic(stack.back()).position.y < top_before - 0.5f,
+              std::format("the boxes above fall into the gap (batch {})", batch));
+    }
+}
+
+// Statics under a few layers of bodies thrown at each other, stepped until
+// there are contacts cached.
+std::vector<phys::DynamicID> make_snapshot_world(phys::PhysicsSystem& physics, int side)
+{
+    std::vector<phys::StaticObject>  statics;
+    std::vector<phys::DynamicObject> dynamics;
+    for (int i = 0; i < side * side; i++)
+    {
+        statics.push_back({ glm::vec3(float(i % side), -3.0f, float(i / side)) });
+    }
+    for (int layer = 0; layer < 3; layer++)
+    {
+        for (int i = 0; i < side * side; i += 2)
+        {
+            float spin = float((i * 7 + layer * 3) % 11) * 0.1f - 0.5f;
+            dynamics.push_back({ glm::vec3(float(i % side) + spin * 0.5f, -1.5f + 1.2f * float(layer), float(i / side) - spin * 0.5f),
+                                 glm::vec3(spin, 0.0f, -spin), glm::vec3(0.0f), 1.0f });
+        }
+    }
+    dynamics.push_back({ glm::vec3(1.0f, -1.0f, 1.0f), glm::vec3(0.0f), glm::vec3(0.0f), 2.0f, glm::vec3(0.4f), phys::ShapeType::sphere });
+
+    std::vector<phys::StaticID>  static_ids;
+    std::vector<phys::DynamicID> dynamic_ids;
+    physics.add_statics(statics, static_ids);
+    physics.add_dynamics(dynamics, dynamic_ids);
+    for (int tick = 0; tick < 30; tick++)
+    {
+        physics.step(1.0f / 60.0f);
+    }
+    return dynamic_ids;
+}
+
+std::vector<float> dynamic_state(phys::PhysicsSystem& physics, const std::vector<phys::DynamicID>& ids)
+{
+    std::vector<float> state;
+    for (phys::DynamicID id : ids)
+    {
+        phys::DynamicObjectRef object = physics.get_dynamic(id);
+        state.insert(state.end(), { object.position.x, object.position.y, object.position.z,
+                                    object.velocity.x, object.velocity.y, object.velocity.z });
+    }
+    return state;
+}
+
+void test_snapshot_round_trip()
+{
+    phys::PhysicsSystem          physics(std::make_shared<phys::JobSystem>(4));
+    std::vector<phys::DynamicID> ids = make_snapshot_world(physics, 12);
+
+    auto play = [&physics, &ids]()
+    {
+        for (int tick = 0; tick < 60; tick++)
+        {
+            physics.step(1.0f / 60.0f);
+            if (tick == 10)
+            {
+                physics.remove_dynamic(ids[5]);
+                physics.add_dynamic(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f);
+                physics.apply_force(ids[9], glm::vec3(0.0f, 800.0f, 0.0f));
+            }
+        }
+    };
+
+    phys::WorldSnapshot start;
+    physics.snapshot(start);
+    play();
+    std::vector<phys::DynamicID> live = ids;
+    live.erase(live.begin() + 5);
+    std::vector<float>  first_state = dynamic_state(physics, live);
+    phys::WorldSnapshot first_end;
+    physics.snapshot(first_end);
+
+    physics.restore(start);
+    play();
+    phys::WorldSnapshot second_end;
+    physics.snapshot(second_end);
+    check(dynamic_state(physics, live) == first_state, "replaying from a restore ends in the same state");
+    check(second_end.bytes == first_end.bytes, "replaying from a restore ends in the same snapshot");
+
+    phys::PhysicsSystem fresh(std::make_shared<phys::JobSystem>(2));
+    fresh.restore(second_end);
+    for (int tick = 0; tick < 30; tick++)
+    {
+        physics.step(1.0f / 60.0f);
+        fresh.step(1.0f / 60.0f);
+    }
+    check(dynamic_state(fresh, live) == dynamic_state(physics, live), "a new system restored from a snapshot steps the same");
+}
+
+void test_snapshot_delta()
+{
+    phys::PhysicsSystem physics(std::make_shared<phys::JobSystem>(1));
+    make_snapshot_world(physics, 12);
+
+    phys::WorldSnapshot base;
+    physics.snapshot(base);
+    for (int tick = 0; tick < 10; tick++)
+    {
+        physics.step(1.0f / 60.0f);
+    }
+    phys::WorldSnapshot later;
+    physics.snapshot(later);
+
+    phys::WorldSnapshotDelta delta;
+    phys::make_snapshot_delta(base, later, delta);
+    phys::WorldSnapshot rebuilt;
+    phys::apply_snapshot_delta(base, delta, rebuilt);
+    check(rebuilt.bytes == later.bytes, "a delta rebuilds the snapshot it was made from");
+
+    phys::WorldSnapshot in_place = base;
+    phys::apply_snapshot_delta(in_place, delta, in_place);
+    check(in_place.bytes == later.bytes, "a delta applies in place");
+
+    phys::WorldSnapshot other_base = base;
+    other_base.bytes.resize(other_base.bytes.size() + 1);
+    bool threw = false;
+    try
+    {
+        phys::apply_snapshot_delta(other_base, delta, rebuilt);
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    check(threw, "a delta against a different base throws");
+}
+
+// Restores a snapshot that has to throw and checks the world it was restored
+// into carries on as if nothing happened.
+bool restore_fails_cleanly(phys::PhysicsSystem& physics, const phys::WorldSnapshot& bad, const phys::WorldSnapshot& before)
+{
+    try
+    {
+        physics.restore(bad);
+        return false;
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+
+    phys::WorldSnapshot after;
+    physics.snapshot(after);
+    return after.bytes == before.bytes;
+}
+
+void test_failed_restore_leaves_world()
+{
+    phys::PhysicsSystem          physics(std::make_shared<phys::JobSystem>(1));
+    std::vector<phys::DynamicID> ids = make_snapshot_world(physics, 4);
+    physics.set_sleeping(false);
+    phys::WorldSnapshot good;
+    physics.snapshot(good);
+
+    for (int tick = 0; tick < 10; tick++)
+    {
+        physics.step(1.0f / 60.0f);
+    }
+    phys::WorldSnapshot current;
+    physics.snapshot(current);
+
+    size_t failed_lengths = 0;
+    for (size_t length = 0; length < good.bytes.size(); length++)
+    {
+        phys::WorldSnapshot truncated;
+        truncated.bytes.assign(good.bytes.begin(), good.bytes.begin() + length);
+        failed_lengths += restore_fails_cleanly(physics, truncated, current) ? 0 : 1;
+    }
+    check(failed_lengths == 0, std::format("every truncated snapshot throws and leaves the world as it was ({} didn't)", failed_lengths));
+
+    // The body list's handles, stored as a count and then the handles in order.
+    // Swapping two leaves them pointing at each other's slots.
+    std::vector<uint32_t> handles = { uint32_t(ids.size()), 0 };
+    for (phys::DynamicID id : ids)
+    {
+        handles.push_back(id.value);
+    }
+    auto pattern_begin = reinterpret_cast<const std::byte*>(handles.data());
+    auto pattern_end   = pattern_begin + handles.size() * sizeof(uint32_t);
+    auto found         = std::find_end(good.bytes.begin(), good.bytes.end(), pattern_begin, pattern_end);
+    check(found != good.bytes.end(), "the snapshot holds the body handles in the order they were added");
+    if (found != good.bytes.end())
+    {
+        phys::WorldSnapshot swapped = good;
+        std::byte*          first   = swapped.bytes.data() + (found - good.bytes.begin()) + sizeof(uint64_t);
+        std::swap_ranges(first, first + sizeof(uint32_t), first + sizeof(uint32_t));
+        check(restore_fails_cleanly(physics, swapped, current), "a snapshot whose handles don't match its slots throws and leaves the world as it was");
+    }
+
+    physics.restore(good);
+    phys::WorldSnapshot restored;
+    physics.snapshot(restored);
+    check(restored.bytes == good.bytes, "a good snapshot still restores after the failed ones");
+}
+
+// Loads a prebuilt tree over objects and reports whether it was accepted,
+// checking a refused one left no statics behind.
+bool prebuilt_tree_loads(const std::vector<phys::StaticObject>& objects, const std::vector<phys::BVHNode>& nodes, int32_t root)
+{
+    phys::PhysicsSystem physics(std::make_shared<phys::JobSystem>(1));
+    physics.set_static_broadphase(phys::StaticBroadphase::bvh);
+    std::vector<phys::StaticID> ids;
+    try
+    {
+        physics.add_statics(objects, nodes, root, ids);
+    }
+    catch (const std::runtime_error&)
+    {
+        std::vector<uint32_t> found;
+        physics.query_statics(glm::vec3(-100.0f), glm::vec3(100.0f), found);
+        check(found.empty() and ids.empty(), "a refused tree adds no statics");
+        return false;
+    }
+    return true;
+}
+
+void test_prebuilt_tree_bounds()
+{
+    std::vector<phys::StaticObject> objects;
+    std::vector<phys::BVHItem>      items;
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        glm::vec3 position(float(i % 8), 0.0f, float(i / 8));
+        objects.push_back({ position });
+        items.push_back({ i, position - objects.back().half_extents, position + objects.back().half_extents });
+    }
+    phys::StaticBVH bvh;
+    bvh.build(items);
+    const std::vector<phys::BVHNode>& nodes = bvh.get_nodes();
+    int32_t                           root  = bvh.get_root();
+    check(prebuilt_tree_loads(objects, nodes, root), "the tree built over the objects loads");
+
+    std::vector<phys::StaticObject> moved = objects;
+    moved[17].position.y += 5.0f;
+    check(not prebuilt_tree_loads(moved, nodes, root), "a tree whose leaf misses its object is refused");
+
+    std::vector<phys::BVHNode> shrunk = nodes;
+    for (phys::BVHNode& node : shrunk)
+    {
+        if (node.left != -1 and node.parent != -1)
+        {
+            node.max.x -= 1.0f;
+            break;
+        }
+    }
+    check(not prebuilt_tree_loads(objects, shrunk, root), "a tree whose parent misses its children is refused");
+
+    std::vector<phys::BVHNode> not_a_number = nodes;
+    not_a_number[root].min.z = std::numeric_limits<float>::quiet_NaN();
+    check(not prebuilt_tree_loads(objects, not_a_number, root), "a tree with a NaN bound is refused");
+}
+
+}
+
+int main()
+{
+    const std::vector<std::pair<const char*, std::function<void()>>> tests =
+    {
+        { "parallel_for rethrows", test_parallel_for_rethrows },
+        { "removing a sleeping body wakes its island", test_removing_sleeping_body_wakes_island },
+        { "snapshot round trip", test_snapshot_round_trip },
+        { "snapshot delta", test_snapshot_delta },
+        { "failed restore leaves the world as it was", test_failed_restore_leaves_world },
+        { "prebuilt tree bounds are checked", test_prebuilt_tree_bounds },
+    };
+
+    for (const auto& [name, test] : tests)
+    {
+        int failed_before = failed_checks;
+        std::cout << name << std::endl;
+        try
+        {
+            test();
+        }
+        catch (const std::exception& exception)
+        {
+            check(false, std::format("unexpected exception: {}", exception.what()));
+        }
+        std::cout << ((failed_checks == failed_before) ? "    ok" : "    FAILED") << std::endl;
+    }
+
+    return (failed_checks == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
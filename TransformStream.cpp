@@ -0,0 +1,122 @@
+#include "TransformStream.hpp"
+
+void gfx::TransformStream::wait_for_region(size_t index)
+{
+    GLsync& fence = fences[index];
+    if (fence == nullptr)
+    {
+        return;
+    }
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED and result != GL_CONDITION_SATISFIED)
+    {
+        stalls++;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000); // 1ms
+        }
+        while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void gfx::TransformStream::allocate(size_t new_capacity)
+{
+    for (size_t i = 0; i < TRANSFORM_STREAM_REGIONS; i++)
+    {
+        wait_for_region(i);
+    }
+    if (buffer != 0)
+    {
+        if (mapped != nullptr)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+    capacity   = new_capacity;
+    region     = 0;
+    persistent = GLAD_GL_VERSION_4_4;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (persistent)
+    {
+        // Coherent, so writes don't need an explicit flush before drawing.
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        size_t     size  = capacity * TRANSFORM_STREAM_REGIONS * sizeof(glm::vec3);
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        mapped = (glm::vec3*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        if (mapped == nullptr)
+        {
+            throw std::runtime_error("gfx::TransformStream::allocate() failed. Could not persistently map the stream buffer.");
+        }
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+        staging.resize(capacity);
+    }
+}
+
+glm::vec3* gfx::TransformStream::begin_frame(size_t count)
+{
+    this->count = count;
+    if (count > capacity or buffer == 0)
+    {
+        // Grow geometrically so a slowly growing scene doesn't reallocate every frame.
+        allocate(std::max(count, capacity * 2));
+    }
+
+    if (not persistent)
+    {
+        return staging.data();
+    }
+
+    wait_for_region(region);
+    return mapped + region * capacity;
+}
+
+void gfx::TransformStream::finish_writes()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (not persistent)
+    {
+        // Orphan first so the driver can hand out fresh storage instead of
+        // waiting for last frame's draws.
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::vec3), staging.data());
+    }
+}
+
+void gfx::TransformStream::end_frame()
+{
+    if (not persistent)
+    {
+        return;
+    }
+
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % TRANSFORM_STREAM_REGIONS;
+}
+
+size_t gfx::TransformStream::get_frame_offset() const
+{
+    return persistent ? region * capacity * sizeof(glm::vec3) : 0;
+}
+
+uint32_t gfx::TransformStream::get_buffer() const
+{
+    return buffer;
+}
+
+size_t gfx::TransformStream::get_stall_count() const
+{
+    return stalls;
+}
\ No newline at end of file
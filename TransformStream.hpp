@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace gfx
+{
+
+constexpr size_t TRANSFORM_STREAM_REGIONS = 3; // frames the CPU may run ahead of the GPU
+
+/// <summary>
+/// Ring buffer that per-instance translations are streamed through every frame.
+/// On GL 4.4+ the buffer is persistently mapped and split into three regions,
+/// so the CPU writes one region while the GPU may still be reading the other
+/// two. Each region gets a fence, and it is only waited on when the CPU wraps
+/// back around to it. Older contexts fall back to orphaning the buffer and
+/// uploading with glBufferSubData.
+///
+/// Each frame: begin_frame(), write the returned pointer, finish_writes(),
+/// draw using get_frame_offset(), then end_frame() once the draws are issued.
+/// </summary>
+class TransformStream
+{
+  private:
+    uint32_t   buffer     = 0;
+    size_t     capacity   = 0;       // in instances, per region
+    bool       persistent = false;
+    glm::vec3* mapped     = nullptr; // start of region 0 when persistent
+
+    std::array<GLsync, TRANSFORM_STREAM_REGIONS> fences{};
+    size_t                                       region = 0;
+    size_t                                       count  = 0; // instances written this frame
+
+    std::vector<glm::vec3> staging{}; // fallback path only
+
+    size_t stalls = 0;
+
+    /// <summary>
+    /// Blocks until the GPU is done with a region, if it was ever fenced.
+    /// </summary>
+    void wait_for_region(size_t index);
+
+    void allocate(size_t new_capacity);
+
+  public:
+    /// <summary>
+    /// Returns where the translations for this frame go. The buffer grows (and
+    /// stalls once to do so) if count doesn't fit.
+    /// </summary>
+    glm::vec3* begin_frame(size_t count);
+
+    /// <summary>
+    /// Makes this frame's writes visible to GL. Leaves the stream buffer bound
+    /// to GL_ARRAY_BUFFER, so attribute pointers can be set right after.
+    /// </summary>
+    void finish_writes();
+
+    /// <summary>
+    /// Fences the region just drawn from and moves on to the next one.
+    /// </summary>
+    void end_frame();
+
+    /// <summary>
+    /// Byte offset of this frame's data inside the buffer.
+    /// </summary>
+    size_t get_frame_offset() const;
+
+    uint32_t get_buffer() const;
+
+    /// <summary>
+    /// How many times begin_frame() had to actually wait on the GPU.
+    /// </summary>
+    size_t get_stall_count() const;
+};
+
+}
\ No newline at end of file
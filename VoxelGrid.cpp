@@ -0,0 +1,195 @@
+#include "VoxelGrid.hpp"
+
+phys::VoxelGrid::VoxelGrid(const glm::vec3& offset)
+    :
+    offset(offset)
+{
+}
+
+void phys::VoxelGrid::set_offset(const glm::vec3& offset)
+{
+    if (not chunks.empty())
+    {
+        throw std::runtime_error("phys::VoxelGrid::set_offset() failed. Grid is not empty.");
+    }
+    this->offset = offset;
+}
+
+const glm::vec3& phys::VoxelGrid::get_offset() const
+{
+    return offset;
+}
+
+uint64_t phys::VoxelGrid::make_key(int32_t x, int32_t y, int32_t z)
+{
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    return  (static_cast<uint64_t>(x) & mask)
+         | ((static_cast<uint64_t>(y) & mask) << 21)
+         | ((static_cast<uint64_t>(z) & mask) << 42);
+}
+
+uint32_t phys::VoxelGrid::local_index(int32_t x, int32_t y, int32_t z)
+{
+    const int32_t mask = CHUNK_SIZE - 1;
+    return static_cast<uint32_t>((x & mask) | ((y & mask) << CHUNK_BITS) | ((z & mask) << (2 * CHUNK_BITS)));
+}
+
+uint32_t phys::VoxelGrid::rank(const Chunk& chunk, uint32_t index)
+{
+    uint32_t word = index >> 6;
+    uint64_t below = chunk.occupied[word] & ((uint64_t(1) << (index & 63)) - 1);
+    return chunk.word_ranks[word] + static_cast<uint32_t>(std::popcount(below));
+}
+
+bool phys::VoxelGrid::to_cell(const glm::vec3& position, int32_t& x, int32_t& y, int32_t& z) const
+{
+    glm::vec3 local = position - offset;
+    glm::vec3 cell  = glm::round(local);
+    x = static_cast<int32_t>(cell.x);
+    y = static_cast<int32_t>(cell.y);
+    z = static_cast<int32_t>(cell.z);
+    return cell == local;
+}
+
+void phys::VoxelGrid::insert(uint32_t handle, const glm::vec3& position)
+{
+    int32_t x, y, z;
+    if (not to_cell(position, x, y, z))
+    {
+        throw std::runtime_error("phys::VoxelGrid::insert() failed. Static is not on a cell centre.");
+    }
+
+    Chunk&   chunk = chunks[make_key(x >> CHUNK_BITS, y >> CHUNK_BITS, z >> CHUNK_BITS)];
+    uint32_t index = local_index(x, y, z);
+    uint32_t word  = index >> 6;
+    uint64_t bit   = uint64_t(1) << (index & 63);
+    if (chunk.occupied[word] & bit)
+    {
+        throw std::runtime_error("phys::VoxelGrid::insert() failed. Cell already holds a static.");
+    }
+
+    chunk.handles.insert(chunk.handles.begin() + rank(chunk, index), handle);
+    chunk.occupied[word] |= bit;
+    for (uint32_t i = word + 1; i < CHUNK_WORDS; i++)
+    {
+        chunk.word_ranks[i]++;
+    }
+}
+
+void phys::VoxelGrid::remove(const glm::vec3& position)
+{
+    int32_t x, y, z;
+    if (not to_cell(position, x, y, z))
+    {
+        return;
+    }
+
+    auto found = chunks.find(make_key(x >> CHUNK_BITS, y >> CHUNK_BITS, z >> CHUNK_BITS));
+    if (found == chunks.end())
+    {
+        return;
+    }
+
+    Chunk&   chunk = found->second;
+    uint32_t index = local_index(x, y, z);
+    uint32_t word  = index >> 6;
+    uint64_t bit   = uint64_t(1) << (index & 63);
+    if (not (chunk.occupied[word] & bit))
+    {
+        return;
+    }
+
+    chunk.handles.erase(chunk.handles.begin() + rank(chunk, index));
+    chunk.occupied[word] &= ~bit;
+    for (uint32_t i = word + 1; i < CHUNK_WORDS; i++)
+    {
+        chunk.word_ranks[i]--;
+    }
+
+    if (chunk.handles.empty())
+    {
+        chunks.erase(found);
+    }
+}
+
+bool phys::VoxelGrid::can_insert(const glm::vec3& position) const
+{
+    int32_t x, y, z;
+    return to_cell(position, x, y, z) and not is_occupied(x, y, z);
+}
+
+uint32_t phys::VoxelGrid::get(int32_t x, int32_t y, int32_t z) const
+{
+    auto found = chunks.find(make_key(x >> CHUNK_BITS, y >> CHUNK_BITS, z >> CHUNK_BITS));
+    if (found == chunks.end())
+    {
+        return INVALID_HANDLE;
+    }
+
+    const Chunk& chunk = found->second;
+    uint32_t     index = local_index(x, y, z);
+    if (not (chunk.occupied[index >> 6] & (uint64_t(1) << (index & 63))))
+    {
+        return INVALID_HANDLE;
+    }
+    return chunk.handles[rank(chunk, index)];
+}
+
+bool phys::VoxelGrid::is_occupied(int32_t x, int32_t y, int32_t z) const
+{
+    return get(x, y, z) != INVALID_HANDLE;
+}
+
+void phys::VoxelGrid::query(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const
+{
+    out.clear();
+
+    // Cell c covers [c - 0.5, c + 0.5], so these are the cells touching the box.
+    glm::vec3 low  = min - offset;
+    glm::vec3 high = max - offset;
+    int32_t min_x = static_cast<int32_t>(std::ceil(low.x - 0.5f)), max_x = static_cast<int32_t>(std::floor(high.x + 0.5f));
+    int32_t min_y = static_cast<int32_t>(std::ceil(low.y - 0.5f)), max_y = static_cast<int32_t>(std::floor(high.y + 0.5f));
+    int32_t min_z = static_cast<int32_t>(std::ceil(low.z - 0.5f)), max_z = static_cast<int32_t>(std::floor(high.z + 0.5f));
+
+    // Walk the chunks the box covers, then the covered cells inside each one,
+    // so each chunk is only hashed once. A body's box is a few cells wide, so
+    // that is usually a single chunk.
+    for (int32_t chunk_z = min_z >> CHUNK_BITS; chunk_z <= max_z >> CHUNK_BITS; chunk_z++)
+    {
+        for (int32_t chunk_y = min_y >> CHUNK_BITS; chunk_y <= max_y >> CHUNK_BITS; chunk_y++)
+        {
+            for (int32_t chunk_x = min_x >> CHUNK_BITS; chunk_x <= max_x >> CHUNK_BITS; chunk_x++)
+            {
+                auto found = chunks.find(make_key(chunk_x, chunk_y, chunk_z));
+                if (found == chunks.end())
+                {
+                    continue;
+                }
+                const Chunk& chunk = found->second;
+
+                int32_t begin_x = std::max(min_x, chunk_x << CHUNK_BITS), end_x = std::min(max_x, (chunk_x << CHUNK_BITS) + CHUNK_SIZE - 1);
+                int32_t begin_y = std::max(min_y, chunk_y << CHUNK_BITS), end_y = std::min(max_y, (chunk_y << CHUNK_BITS) + CHUNK_SIZE - 1);
+                int32_t begin_z = std::max(min_z, chunk_z << CHUNK_BITS), end_z = std::min(max_z, (chunk_z << CHUNK_BITS) + CHUNK_SIZE - 1);
+                for (int32_t z = begin_z; z <= end_z; z++)
+                {
+                    for (int32_t y = begin_y; y <= end_y; y++)
+                    {
+                        for (int32_t x = begin_x; x <= end_x; x++)
+                        {
+                            uint32_t index = local_index(x, y, z);
+                            if (chunk.occupied[index >> 6] & (uint64_t(1) << (index & 63)))
+                            {
+                                out.push_back(chunk.handles[rank(chunk, index)]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void phys::VoxelGrid::clear()
+{
+    chunks.clear();
+}
\ No newline at end of file
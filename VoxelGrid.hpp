@@ -0,0 +1,103 @@
+#pragma once
+#include "PagedSparseArray.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <bit>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace phys
+{
+
+/// <summary>
+/// Occupancy grid for unit statics lined up on a lattice of unit cells, one
+/// cell per static. Cell centres sit at integer coordinates plus an offset. Space is split into 16x16x16 chunks that are only allocated
+/// once something is in them. A chunk keeps one bit per cell, plus the handles
+/// of its occupied cells packed in cell order, so looking up a cell is a bit
+/// test and a popcount no matter how many statics the world has.
+/// </summary>
+class VoxelGrid
+{
+  private:
+    static constexpr int32_t  CHUNK_BITS  = 4;
+    static constexpr int32_t  CHUNK_SIZE  = 1 << CHUNK_BITS;                    // cells per axis
+    static constexpr uint32_t CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+    static constexpr uint32_t CHUNK_WORDS = CHUNK_CELLS / 64;
+
+    struct Chunk
+    {
+        uint64_t              occupied[CHUNK_WORDS] = {};
+        uint16_t              word_ranks[CHUNK_WORDS] = {}; // occupied cells in all words before this one
+        std::vector<uint32_t> handles{};                    // one per occupied cell, in cell order
+    };
+
+    glm::vec3                           offset;
+    std::unordered_map<uint64_t, Chunk> chunks{};
+
+    /// <summary>
+    /// Packs three signed chunk coordinates into one key, 21 bits per axis.
+    /// </summary>
+    static uint64_t make_key(int32_t x, int32_t y, int32_t z);
+
+    /// <summary>
+    /// Index of a cell inside its chunk.
+    /// </summary>
+    static uint32_t local_index(int32_t x, int32_t y, int32_t z);
+
+    /// <summary>
+    /// Position in Chunk::handles of an occupied cell, or of where it would go.
+    /// </summary>
+    static uint32_t rank(const Chunk& chunk, uint32_t index);
+
+    /// <summary>
+    /// Cell a static is centred on. False if the position isn't on a cell
+    /// centre, since the static wouldn't line up with any cell.
+    /// </summary>
+    bool to_cell(const glm::vec3& position, int32_t& x, int32_t& y, int32_t& z) const;
+
+  public:
+    /// <param name="offset">: position of the centre of cell (0, 0, 0)</param>
+    VoxelGrid(const glm::vec3& offset = glm::vec3(0.0f));
+
+    /// <summary>
+    /// Moves the cell lattice. Only allowed while the grid is empty.
+    /// </summary>
+    void set_offset(const glm::vec3& offset);
+
+    const glm::vec3& get_offset() const;
+
+    /// <summary>
+    /// Throws unless can_insert(position).
+    /// </summary>
+    void insert(uint32_t handle, const glm::vec3& position);
+
+    /// <summary>
+    /// True if the position is on a cell centre and that cell is empty.
+    /// </summary>
+    bool can_insert(const glm::vec3& position) const;
+
+    void remove(const glm::vec3& position);
+
+    /// <summary>
+    /// Handle of the static filling the cell at offset + (x, y, z), INVALID_HANDLE if it is empty.
+    /// </summary>
+    uint32_t get(int32_t x, int32_t y, int32_t z) const;
+
+    bool is_occupied(int32_t x, int32_t y, int32_t z) const;
+
+    /// <summary>
+    /// Collects the handles of every static whose cell touches the given box.
+    /// Each cell holds at most one static, so no handle appears twice.
+    /// </summary>
+    /// <param name="out">: cleared, then filled with candidate handles</param>
+    void query(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const;
+
+    void clear();
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "WorldSnapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+void phys::make_snapshot_delta(const WorldSnapshot& base, const WorldSnapshot& snapshot, WorldSnapshotDelta& delta)
+{
+    const std::vector<std::byte>& from = base.bytes;
+    const std::vector<std::byte>& to   = snapshot.bytes;
+
+    delta.base_size = from.size();
+    delta.size      = to.size();
+    delta.runs.clear();
+    delta.bytes.clear();
+
+    size_t block_count = (to.size() + SNAPSHOT_DELTA_BLOCK_SIZE - 1) / SNAPSHOT_DELTA_BLOCK_SIZE;
+    for (size_t block = 0; block < block_count; block++)
+    {
+        size_t start  = block * SNAPSHOT_DELTA_BLOCK_SIZE;
+        size_t length = std::min(SNAPSHOT_DELTA_BLOCK_SIZE, to.size() - start);
+
+        bool changed = start + length > from.size() or std::memcmp(from.data() + start, to.data() + start, length) != 0;
+        if (not changed)
+        {
+            continue;
+        }
+
+        if (not delta.runs.empty() and delta.runs.back().first + delta.runs.back().second == block)
+        {
+            delta.runs.back().second++;
+        }
+        else
+        {
+            delta.runs.emplace_back(block, 1);
+        }
+        delta.bytes.insert(delta.bytes.end(), to.begin() + start, to.begin() + start + length);
+    }
+}
+
+void phys::apply_snapshot_delta(const WorldSnapshot& base, const WorldSnapshotDelta& delta, WorldSnapshot& snapshot)
+{
+    if (base.bytes.size() != delta.base_size)
+    {
+        throw std::runtime_error("phys::apply_snapshot_delta() failed. The delta was made against a different base.");
+    }
+
+    // Checked before touching snapshot, which may be the base.
+    uint64_t block_count = (delta.size + SNAPSHOT_DELTA_BLOCK_SIZE - 1) / SNAPSHOT_DELTA_BLOCK_SIZE;
+    uint64_t next_block  = 0;
+    uint64_t byte_count  = 0;
+    for (auto [first, count] : delta.runs)
+    {
+        if (first < next_block or count == 0 or count > block_count - first)
+        {
+            throw std::runtime_error("phys::apply_snapshot_delta() failed. Runs are out of order or out of range.");
+        }
+        next_block  = first + count;
+        byte_count += std::min<uint64_t>(count * SNAPSHOT_DELTA_BLOCK_SIZE, delta.size - first * SNAPSHOT_DELTA_BLOCK_SIZE);
+    }
+    if (byte_count != delta.bytes.size())
+    {
+        throw std::runtime_error("phys::apply_snapshot_delta() failed. Runs don't match the delta's bytes.");
+    }
+
+    if (&snapshot != &base)
+    {
+        snapshot.bytes.assign(base.bytes.begin(), base.bytes.begin() + std::min(base.bytes.size(), size_t(delta.size)));
+    }
+    snapshot.bytes.resize(delta.size);
+
+    const std::byte* source = delta.bytes.data();
+    for (auto [first, count] : delta.runs)
+    {
+        size_t start  = first * SNAPSHOT_DELTA_BLOCK_SIZE;
+        size_t length = std::min<size_t>(count * SNAPSHOT_DELTA_BLOCK_SIZE, delta.size - start);
+        std::memcpy(snapshot.bytes.data() + start, source, length);
+        source += length;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+// Written first in every snapshot. Bump it whenever anything saved changes
+// layout, older snapshots are then rejected instead of misread.
+constexpr uint32_t WORLD_SNAPSHOT_VERSION = 1;
+
+/// <summary>
+/// Everything a PhysicsSystem needs to carry on simulating from one tick, as
+/// one flat buffer, see PhysicsSystem::snapshot(). Raw memory, so only the
+/// build that wrote it can restore it. Buffers are reused, keep one around
+/// per slot rather than making a new one per save.
+/// </summary>
+struct WorldSnapshot
+{
+    std::vector<std::byte> bytes{};
+};
+
+constexpr size_t SNAPSHOT_DELTA_BLOCK_SIZE = 64; // bytes compared at a time, one cache line
+
+/// <summary>
+/// The blocks in which a snapshot differs from an older base snapshot.
+/// Sleeping bodies don't change between ticks and the fields bodies never
+/// write to (mass, shape) don't change at all, so this is usually a fraction of
+/// the full snapshot. Blocks are compared at the same offset, so everything
+/// saved after something that grew or shrank counts as changed.
+/// </summary>
+struct WorldSnapshotDelta
+{
+    uint64_t                                   base_size = 0;
+    uint64_t                                   size      = 0;  // of the snapshot it rebuilds
+    std::vector<std::pair<uint64_t, uint64_t>> runs{};         // first block and block count of each run of changed blocks
+    std::vector<std::byte>                     bytes{};        // the changed blocks, back to back
+};
+
+/// <summary>
+/// Fills delta with what turns base into snapshot, replacing what it held.
+/// </summary>
+void make_snapshot_delta(const WorldSnapshot& base, const WorldSnapshot& snapshot, WorldSnapshotDelta& delta);
+
+/// <summary>
+/// Rebuilds the snapshot a delta was made from. snapshot may be base itself,
+/// which is then patched in place. Throws if the delta wasn't made against a
+/// base of this size or its runs don't match its bytes.
+/// </summary>
+void apply_snapshot_delta(const WorldSnapshot& base, const WorldSnapshotDelta& delta, WorldSnapshot& snapshot);
+
+}
\ No newline at end of file
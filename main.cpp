@@ -9,9 +9,11 @@ int main()
     std::shared_ptr<gfx::ShaderSystem>    shader_system    = std::make_shared<gfx::ShaderSystem>();
     std::shared_ptr<gfx::MeshRegistry>    mesh_registry    = std::make_shared<gfx::MeshRegistry>();
     std::shared_ptr<phys::PhysicsSystem>  physics_system   = std::make_shared<phys::PhysicsSystem>();
-    std::shared_ptr<gfx::RenderingSystem> rendering_system = std::make_shared<gfx::RenderingSystem>(mesh_registry, physics_system);
+    std::shared_ptr<gfx::RenderingSystem> rendering_system = std::make_shared<gfx::RenderingSystem>(mesh_registry, shader_system, physics_system);
 
     PhysSimApplication app(shader_system, mesh_registry, physics_system, rendering_system);
+    app.set_threaded_physics(true);
+    app.set_tick_rate(30.0);
     try
     {
         app.run();
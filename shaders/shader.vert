@@ -1,6 +1,7 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec3 aOffset; // per instance
 
 out vec3 color;
 
@@ -10,6 +11,6 @@ uniform mat4 projection;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * (model * vec4(aPos, 1.0) + vec4(aOffset, 0.0));
     color = aColor;
 }
\ No newline at end of file